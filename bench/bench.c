@@ -0,0 +1,387 @@
+/**
+ * @file bench.c
+ * @brief Throughput benchmark for the cipher library.
+ *
+ * Sweeps the fast paths of libcipher.a over key (1 .. 10^6), frame length
+ * (1 .. CIPHER_MAX_INPUT_LEN) and input mix (all in-alphabet vs. mostly
+ * pass-through), and prints one CSV row per point. Covered: strings,
+ * _buf, _strict, _to, the *64 variants, uppercase, key handles, batch,
+ * bulk, column, iov, plans, the plan cache, jobs, streams and the packed
+ * format (strict and packed only with in-alphabet input, where they
+ * succeed). Not covered: custom-table ctx calls, the TX ring and the
+ * host-only libcipher_mt / libcipher_file. Output:
+ *
+ *   api,key,len,input,iterations,cycles_per_byte,mb_per_s
+ *
+ * Timing comes from BENCH_CYCLES(), a 32-bit cycle counter hook:
+ *   - Cortex-M3/M4/M7/M33: the DWT cycle counter (DWT->CYCCNT)
+ *   - x86 hosts:           rdtsc
+ *   - other hosts:         CLOCK_MONOTONIC nanoseconds
+ * Define BENCH_CYCLES() (and BENCH_CPU_HZ) to plug in another counter; on
+ * bare-metal cores without DWT (Cortex-M0/M0+) that is required, e.g. a
+ * SysTick-based count.
+ * MB/s is derived from cycles and BENCH_CPU_HZ on bare metal, and from the
+ * monotonic clock on hosts.
+ *
+ * Build and run (from repo root):
+ *   make bench
+ *   make tune          (kernel dispatch table for this CPU, as C source)
+ *
+ * @author Rushikesh Kaduskar
+ */
+#if !defined(__arm__) || defined(__linux__)
+#define _POSIX_C_SOURCE 199309L
+#define BENCH_HOSTED 1
+#endif
+
+#include "cipher.h"
+#include "cipher_job.h"
+#include "cipher_pack.h"
+#include "cipher_plan_cache.h"
+#include "cipher_stream.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(BENCH_HOSTED)
+#include <time.h>
+#endif
+
+/* -------------------------------------------------------------------------
+ * Cycle counter hook
+ * ---------------------------------------------------------------------- */
+#if defined(BENCH_CYCLES)
+    /* user-supplied */
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || \
+      defined(__ARM_ARCH_8M_MAIN__)
+#define DEMCR       (*(volatile uint32_t *)0xE000EDFCU)
+#define DWT_CTRL    (*(volatile uint32_t *)0xE0001000U)
+#define DWT_CYCCNT  (*(volatile uint32_t *)0xE0001004U)
+#define BENCH_CYCLES() (DWT_CYCCNT)
+#define BENCH_CYCLES_INIT()                 \
+    do {                                    \
+        DEMCR     |= (1UL << 24);  /* TRCENA */  \
+        DWT_CYCCNT = 0U;                    \
+        DWT_CTRL  |= 1UL;          /* CYCCNTENA */ \
+    } while (0)
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES() ((uint32_t)__rdtsc())
+#elif defined(BENCH_HOSTED)
+static uint32_t bench_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#define BENCH_CYCLES() bench_monotonic_ns()
+#else
+#error "define BENCH_CYCLES() for this target (no DWT cycle counter)"
+#endif
+
+#ifndef BENCH_CYCLES_INIT
+#define BENCH_CYCLES_INIT() do { } while (0)
+#endif
+
+#ifndef BENCH_CPU_HZ
+#define BENCH_CPU_HZ 168000000UL    /* STM32F4 at full speed */
+#endif
+
+/** Bytes processed per measurement point. */
+#ifndef BENCH_BYTES_PER_POINT
+#define BENCH_BYTES_PER_POINT (256UL * 1024UL)
+#endif
+
+/* -------------------------------------------------------------------------
+ * Fixtures
+ * ---------------------------------------------------------------------- */
+
+#define BATCH_FRAMES 16U
+
+static char            work[CIPHER_MAX_INPUT_LEN + 1U];
+static char            src[CIPHER_MAX_INPUT_LEN + 1U];
+static char            batch_buf[BATCH_FRAMES][CIPHER_MAX_INPUT_LEN];
+static cipher_span_t   batch[BATCH_FRAMES];
+static cipher_status_t batch_status[BATCH_FRAMES];
+static char            column_out[BATCH_FRAMES * CIPHER_MAX_INPUT_LEN];
+static int32_t         column_offsets[BATCH_FRAMES + 1U];
+static size_t          bulk_offsets[BATCH_FRAMES + 1U];
+static cipher_span_t   iov[2];
+static cipher_index_t  plan_index[CIPHER_MAX_INPUT_LEN];
+static cipher_plan_t   plan;
+static cipher_index_t  cache_arena[CIPHER_MAX_INPUT_LEN];
+static cipher_plan_cache_t plan_cache;
+static cipher_key_t    key_handle;
+static unsigned char   packed[CIPHER_PACKED_SIZE(CIPHER_MAX_INPUT_LEN)];
+
+typedef enum { INPUT_ALPHABET, INPUT_PASSTHROUGH } input_mix_t;
+
+static const char *const INPUT_NAMES[2] = { "alphabet", "passthrough" };
+
+/** Fill `buf` with either alphabet symbols or ~90% pass-through bytes. */
+static void fill_input(char *buf, size_t len, input_mix_t mix)
+{
+    static const char alphabet[] = "0123456789ABCDEF:,=;";
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (mix == INPUT_ALPHABET || i % 10U == 0U) {
+            buf[i] = alphabet[(i * 7U) % 20U];
+        } else {
+            buf[i] = (char)('a' + (i % 26U));
+        }
+    }
+    buf[len] = '\0';
+}
+
+/* -------------------------------------------------------------------------
+ * Benchmarked operations: one call processes `len` bytes (batch: 16 frames)
+ * ---------------------------------------------------------------------- */
+
+typedef void (*bench_op_fn)(size_t len, int key);
+
+static void op_encrypt(size_t len, int key)     { (void)len; cipher_encrypt(work, key); }
+static void op_decrypt(size_t len, int key)     { (void)len; cipher_decrypt(work, key); }
+static void op_encrypt_buf(size_t len, int key) { cipher_encrypt_buf(work, len, key); }
+static void op_decrypt_buf(size_t len, int key) { cipher_decrypt_buf(work, len, key); }
+static void op_encrypt_to(size_t len, int key)  { cipher_encrypt_to(src, work, len, key); }
+static void op_decrypt_to(size_t len, int key)  { cipher_decrypt_to(src, work, len, key); }
+static void op_plan_encrypt(size_t len, int key) { (void)len; (void)key; cipher_plan_encrypt(&plan, src, work); }
+static void op_plan_decrypt(size_t len, int key) { (void)len; (void)key; cipher_plan_decrypt(&plan, src, work); }
+static void op_encrypt_strict(size_t len, int key) { cipher_encrypt_buf_strict(work, len, key, NULL); }
+static void op_decrypt_strict(size_t len, int key) { cipher_decrypt_buf_strict(work, len, key, NULL); }
+static void op_encrypt_buf64(size_t len, int key) { cipher_encrypt_buf64(work, len, (uint64_t)key); }
+static void op_decrypt_buf64(size_t len, int key) { cipher_decrypt_buf64(work, len, (uint64_t)key); }
+static void op_encrypt_to64(size_t len, int key)  { cipher_encrypt_to64(src, work, len, (uint64_t)key); }
+static void op_decrypt_to64(size_t len, int key)  { cipher_decrypt_to64(src, work, len, (uint64_t)key); }
+static void op_encrypt_upper(size_t len, int key) { cipher_encrypt_uppercase_buf(work, len, key); }
+static void op_key_encrypt(size_t len, int key) { (void)key; cipher_key_encrypt_buf(&key_handle, work, len); }
+static void op_key_decrypt(size_t len, int key) { (void)key; cipher_key_decrypt_buf(&key_handle, work, len); }
+static void op_decrypt_iov(size_t len, int key) { (void)len; cipher_decrypt_iov(iov, 2, key); }
+static void op_cache_decrypt(size_t len, int key) { cipher_plan_cache_decrypt(&plan_cache, src, work, len, key); }
+static void op_encrypt_packed(size_t len, int key) { cipher_encrypt_packed(src, len, key, packed); }
+static void op_decrypt_packed(size_t len, int key) { cipher_decrypt_packed(packed, len, key, work); }
+
+static void op_decrypt_batch(size_t len, int key)
+{
+    (void)len;
+    cipher_decrypt_batch(batch, BATCH_FRAMES, key, batch_status);
+}
+
+/* The batch frames laid out back to back, size_t offsets */
+static void op_decrypt_bulk(size_t len, int key)
+{
+    (void)len;
+    cipher_decrypt_bulk(&batch_buf[0][0], bulk_offsets, BATCH_FRAMES,
+                        column_out, key, batch_status);
+}
+
+/* The batch frames laid out back to back as one Arrow column */
+static void op_decrypt_column(size_t len, int key)
+{
+    (void)len;
+    cipher_decrypt_column(&batch_buf[0][0], column_offsets, BATCH_FRAMES,
+                          column_out, key, batch_status);
+}
+
+static void stream_sink(void *user, size_t offset, const char *data, size_t len)
+{
+    memcpy((char *)user + offset, data, len);
+}
+
+static void op_stream_encrypt(size_t len, int key)
+{
+    cipher_stream_t stream;
+    size_t pos, n;
+
+    cipher_stream_encrypt_init(&stream, len, key, stream_sink, work);
+    for (pos = 0; pos < len; pos += n) {
+        n = (len - pos < 256U) ? len - pos : 256U;
+        cipher_stream_update(&stream, src + pos, n);
+    }
+}
+
+/* Incremental job in 256-byte steps, as a scheduler would drive it */
+static void op_job_decrypt(size_t len, int key)
+{
+    cipher_job_t job;
+
+    cipher_job_decrypt_init(&job, work, len, key);
+    while (cipher_job_step(&job, 256U) == CIPHER_IN_PROGRESS) {
+    }
+}
+
+typedef struct {
+    const char  *name;
+    bench_op_fn  fn;
+    unsigned     frames;        /* frames per call */
+    int          needs_plan;
+    int          alphabet_only; /* fails on pass-through input */
+} bench_api_t;
+
+static const bench_api_t APIS[] = {
+    { "encrypt",            op_encrypt,        1,            0, 0 },
+    { "decrypt",            op_decrypt,        1,            0, 0 },
+    { "encrypt_buf",        op_encrypt_buf,    1,            0, 0 },
+    { "decrypt_buf",        op_decrypt_buf,    1,            0, 0 },
+    { "encrypt_buf_strict", op_encrypt_strict, 1,            0, 1 },
+    { "decrypt_buf_strict", op_decrypt_strict, 1,            0, 1 },
+    { "encrypt_to",         op_encrypt_to,     1,            0, 0 },
+    { "decrypt_to",         op_decrypt_to,     1,            0, 0 },
+    { "encrypt_buf64",      op_encrypt_buf64,  1,            0, 0 },
+    { "decrypt_buf64",      op_decrypt_buf64,  1,            0, 0 },
+    { "encrypt_to64",       op_encrypt_to64,   1,            0, 0 },
+    { "decrypt_to64",       op_decrypt_to64,   1,            0, 0 },
+    { "encrypt_upper_buf",  op_encrypt_upper,  1,            0, 0 },
+    { "key_encrypt_buf",    op_key_encrypt,    1,            0, 0 },
+    { "key_decrypt_buf",    op_key_decrypt,    1,            0, 0 },
+    { "decrypt_batch",      op_decrypt_batch,  BATCH_FRAMES, 0, 0 },
+    { "decrypt_bulk",       op_decrypt_bulk,   BATCH_FRAMES, 0, 0 },
+    { "decrypt_column",     op_decrypt_column, BATCH_FRAMES, 0, 0 },
+    { "decrypt_iov",        op_decrypt_iov,    1,            0, 0 },
+    { "plan_encrypt",       op_plan_encrypt,   1,            1, 0 },
+    { "plan_decrypt",       op_plan_decrypt,   1,            1, 0 },
+    { "plan_cache_decrypt", op_cache_decrypt,  1,            0, 0 },
+    { "job_decrypt",        op_job_decrypt,    1,            0, 0 },
+    { "stream_encrypt",     op_stream_encrypt, 1,            0, 0 },
+    { "encrypt_packed",     op_encrypt_packed, 1,            0, 1 },
+    { "decrypt_packed",     op_decrypt_packed, 1,            0, 1 },
+};
+
+static const int    KEYS[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+static const size_t LENS[] = { 1, 4, 16, 64, 256, 1024, 4096, CIPHER_MAX_INPUT_LEN };
+
+/* -------------------------------------------------------------------------
+ * Measurement
+ * ---------------------------------------------------------------------- */
+
+#if defined(BENCH_HOSTED)
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+#endif
+
+static void run_point(const bench_api_t *api, int key, size_t len, input_mix_t mix)
+{
+    unsigned long bytes_per_call = (unsigned long)len * api->frames;
+    unsigned long iterations = BENCH_BYTES_PER_POINT / bytes_per_call;
+    unsigned long i;
+    uint64_t cycles = 0;
+    uint32_t start;
+    double seconds, mbps;
+    size_t f;
+
+    if (iterations < 8UL) {
+        iterations = 8UL;
+    }
+
+    fill_input(src, len, mix);
+    memcpy(work, src, len + 1U);
+    for (f = 0; f < BATCH_FRAMES; f++) {
+        memcpy(batch_buf[f], src, len);
+        batch[f].data = batch_buf[f];
+        batch[f].len  = len;
+    }
+    for (f = 0; f <= BATCH_FRAMES; f++) {
+        column_offsets[f] = (int32_t)(f * len);
+        bulk_offsets[f]   = f * len;
+    }
+    iov[0].data = work;
+    iov[0].len  = len / 2U;
+    iov[1].data = work + len / 2U;
+    iov[1].len  = len - len / 2U;
+    if (api->needs_plan) {
+        cipher_plan_init(&plan, plan_index, len, key);
+    }
+    cipher_key_init(&key_handle, key);
+    cipher_encrypt_packed(src, len, key, packed);
+
+    api->fn(len, key);                      /* warm caches */
+
+#if defined(BENCH_HOSTED)
+    seconds = now_seconds();
+#endif
+    for (i = 0; i < iterations; i++) {
+        start = BENCH_CYCLES();
+        api->fn(len, key);
+        cycles += (uint32_t)(BENCH_CYCLES() - start);
+    }
+#if defined(BENCH_HOSTED)
+    seconds = now_seconds() - seconds;
+#else
+    seconds = (double)cycles / (double)BENCH_CPU_HZ;
+#endif
+
+    mbps = (seconds > 0.0)
+         ? (double)bytes_per_call * (double)iterations / seconds / 1e6
+         : 0.0;
+    printf("%s,%d,%lu,%s,%lu,%.3f,%.1f\n",
+           api->name, key, (unsigned long)len, INPUT_NAMES[mix], iterations,
+           (double)cycles / ((double)bytes_per_call * (double)iterations),
+           mbps);
+}
+
+/* -------------------------------------------------------------------------
+ * Kernel tuning: `bench tune` prints the cipher_autotune() result for this
+ * CPU as a const table to paste into firmware (see cipher_tune_use()).
+ * ---------------------------------------------------------------------- */
+
+static uint32_t bench_clock(void)
+{
+    return (uint32_t)BENCH_CYCLES();
+}
+
+static void run_tune(void)
+{
+    static const char *const KERNEL_NAMES[CIPHER_KERNEL_COUNT] = {
+        "CIPHER_KERNEL_SCALAR", "CIPHER_KERNEL_SWAR",
+        "CIPHER_KERNEL_SIMD",   "CIPHER_KERNEL_GATHER",
+    };
+    cipher_tune_t table;
+    size_t b;
+
+    cipher_autotune(bench_clock, work, CIPHER_MAX_INPUT_LEN, &table);
+    printf("/* cipher_autotune() result; install with cipher_tune_use(&cipher_tuned) */\n");
+    printf("static const cipher_tune_t cipher_tuned = { {\n");
+    for (b = 0; b < CIPHER_TUNE_BUCKETS; b++) {
+        printf("    %s,%*s/* len %lu .. %lu */\n", KERNEL_NAMES[table.kernel[b]],
+               (int)(22U - strlen(KERNEL_NAMES[table.kernel[b]])), "",
+               (b == 0U) ? 0UL : 1UL << b,
+               (b + 1U == CIPHER_TUNE_BUCKETS) ? (unsigned long)CIPHER_MAX_INPUT_LEN
+                                               : (2UL << b) - 1UL);
+    }
+    printf("} };\n");
+}
+
+int main(int argc, char **argv)
+{
+    size_t a, k, l;
+    int mix;
+
+    BENCH_CYCLES_INIT();
+    cipher_plan_cache_init(&plan_cache, cache_arena, CIPHER_MAX_INPUT_LEN);
+
+    if (argc > 1 && strcmp(argv[1], "tune") == 0) {
+        run_tune();
+        return 0;
+    }
+
+    printf("api,key,len,input,iterations,cycles_per_byte,mb_per_s\n");
+    for (a = 0; a < sizeof(APIS) / sizeof(APIS[0]); a++) {
+        for (k = 0; k < sizeof(KEYS) / sizeof(KEYS[0]); k++) {
+            for (l = 0; l < sizeof(LENS) / sizeof(LENS[0]); l++) {
+                for (mix = INPUT_ALPHABET; mix <= INPUT_PASSTHROUGH; mix++) {
+                    if (APIS[a].alphabet_only && mix != INPUT_ALPHABET) {
+                        continue;
+                    }
+                    run_point(&APIS[a], KEYS[k], LENS[l], (input_mix_t)mix);
+                }
+            }
+        }
+    }
+    return 0;
+}
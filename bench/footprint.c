@@ -0,0 +1,35 @@
+/**
+ * @file footprint.c
+ * @brief Smallest useful firmware image: in-place encrypt and decrypt of
+ *        one frame. Linked with --gc-sections by `make footprint`.
+ *
+ * Built twice, with and without FOOTPRINT_BASELINE; the difference in
+ * .text / .rodata / RAM is what the in-place entry points cost an image,
+ * without the C runtime around them.
+ *
+ * @author Rushikesh Kaduskar
+ */
+
+#include "cipher.h"
+
+static char frame[64];
+char *volatile footprint_frame = frame;     /* keeps `frame` in both builds */
+
+int main(int argc, char **argv)
+{
+    int key = argc + 40500;
+    size_t len = (size_t)argc * 16U;
+
+    (void)argv;
+    frame[0] = (char)argc;
+#ifndef FOOTPRINT_BASELINE
+    if (cipher_encrypt_buf(frame, len, key) != CIPHER_SUCCESS ||
+        cipher_decrypt_buf(frame, len, key) != CIPHER_SUCCESS) {
+        return 1;
+    }
+#else
+    (void)key;
+    (void)len;
+#endif
+    return frame[0] == (char)argc ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file fuzz_cipher.c
+ * @brief libFuzzer / AFL harness: every entry point against the frozen
+ *        reference (tests/cipher_diff.c).
+ *
+ * Input layout: 4 bytes key (little-endian, any value), 4 bytes split
+ * seed, then the payload (truncated to CIPHER_DIFF_MAX_LEN). Any mismatch
+ * aborts, so the fuzzer keeps the input as a crash.
+ *
+ * libFuzzer (clang):
+ *   make fuzz
+ *   ./build/fuzz_cipher -max_len=10072 corpus/
+ *
+ * AFL++ (a main() that reads one input from a file or stdin):
+ *   make fuzz FUZZ_CC=afl-clang-fast FUZZ_FLAGS=-DCIPHER_FUZZ_MAIN
+ *   afl-fuzz -i seeds -o findings -- ./build/fuzz_cipher @@
+ *
+ * @author Rushikesh Kaduskar
+ */
+
+#include "cipher.h"
+#include "cipher_diff.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint32_t load_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    uint32_t raw_key, seed;
+    size_t len;
+    int key;
+    const char *fail;
+
+    if (size < 8U) {
+        return 0;
+    }
+    raw_key = load_le32(data);
+    seed    = load_le32(data + 4);
+    key     = (raw_key > (uint32_t)INT32_MAX)
+                  ? -(int)(raw_key & 0x7FFFFFFFU) : (int)raw_key;
+    len     = size - 8U;
+    if (len > CIPHER_DIFF_MAX_LEN) {
+        len = CIPHER_DIFF_MAX_LEN;
+    }
+
+    fail = cipher_diff_check((const char *)data + 8, len, key, seed);
+    if (fail != NULL) {
+        fprintf(stderr, "fuzz_cipher: %s differs from the reference "
+                "(len=%lu key=%d seed=0x%08lX)\n", fail, (unsigned long)len,
+                key, (unsigned long)seed);
+        abort();
+    }
+    return 0;
+}
+
+#ifdef CIPHER_FUZZ_MAIN
+/** Standalone driver for AFL and for replaying a saved crash. */
+int main(int argc, char **argv)
+{
+    static uint8_t buf[8U + CIPHER_DIFF_MAX_LEN];
+    FILE *f = stdin;
+    size_t n;
+
+    if (argc > 1) {
+        f = fopen(argv[1], "rb");
+        if (f == NULL) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+    n = fread(buf, 1, sizeof(buf), f);
+    if (f != stdin) {
+        fclose(f);
+    }
+    return LLVMFuzzerTestOneInput(buf, n);
+}
+#endif
@@ -6,7 +6,11 @@
  *   Stage 1 — Split-shift: the input string is split at its midpoint and
  *             each half is independently rotated by `key` positions.
  *   Stage 2 — Substitution: each character is mapped through a fixed
- *             16-symbol hexadecimal substitution table.
+ *             20-entry substitution table (the 16 hex digits plus
+ *             `:`, `,`, `=` and `;`), expanded at build time into
+ *             256-entry direct maps so every byte costs a single load
+ *             (CIPHER_PROFILE_SIZE searches the table instead; see
+ *             cipher_config.h).
  *
  * Designed with embedded constraints in mind:
  *   - No heap allocation (operates in-place on caller's buffer)
@@ -23,17 +27,160 @@
 #define CIPHER_H
 
 #include <stddef.h>
+#include <stdint.h>
+
+#include "cipher_config.h"
 
 #define CIPHER_MAX_INPUT_LEN 10000U
 #define CIPHER_TABLE_SIZE 20U
 
+/*
+ * Word-at-a-time (SWAR) scalar substitution for cores without SIMD
+ * (Cortex-M0+/M3). Reads aligned 32-bit words, skips words that have no
+ * byte in the alphabet's range, and writes mapped words back with a single
+ * store. Set to 1 to enable; ignored when CIPHER_USE_SIMD is on.
+ */
+#ifndef CIPHER_USE_SWAR
+#define CIPHER_USE_SWAR 0
+#endif
+
+/*
+ * Vectorised substitution (SSE4.1/AVX2 on x86, NEON on ARM), picked at run
+ * time from the CPU feature flags. Enabled by default when the compiler
+ * targets a core that has the extensions; define as 0 to force the scalar
+ * path. Cortex-M parts have neither, so bare-metal builds stay scalar.
+ */
+#ifndef CIPHER_USE_SIMD
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__) || defined(__ARM_NEON))
+#define CIPHER_USE_SIMD 1
+#else
+#define CIPHER_USE_SIMD 0
+#endif
+#endif
+
+/*
+ * Instrumentation: per-stage cycle counts, bytes, calls and errors of the
+ * buffer entry points in cipher.c, read with cipher_stats_snapshot(). Set
+ * to 1 to enable; when 0 (the default) the hooks compile to nothing and
+ * the stats functions are empty stubs. See cipher_stats_t for which
+ * thread's calls the counters see.
+ */
+#ifndef CIPHER_ENABLE_STATS
+#define CIPHER_ENABLE_STATS 0
+#endif
+
+/*
+ * Storage of the stats counters: 1 keeps one set per thread (compiler
+ * thread-local storage, the default on GCC/Clang hosts), 0 one global set
+ * (the default elsewhere, where bare-metal runtimes often have no TLS).
+ */
+#ifndef CIPHER_STATS_PER_THREAD
+#if defined(__GNUC__) && (defined(__unix__) || defined(__APPLE__))
+#define CIPHER_STATS_PER_THREAD 1
+#else
+#define CIPHER_STATS_PER_THREAD 0
+#endif
+#endif
+
+/*
+ * Constant-time build: the shift and the substitution of the buffer, _to,
+ * ctx, uppercase, batch and key-handle entry points run in a time that
+ * depends only on the buffer length. The key is reduced with a fixed-length
+ * bitwise modulo, each half is rotated by log2(len) conditional rotations
+ * of masked swaps, and every byte is substituted by a masked scan of the
+ * whole table span (no secret-indexed loads). Several times slower than
+ * the default path and overrides CIPHER_USE_SIMD / CIPHER_USE_SWAR for
+ * those entry points. Strict mode, iov, plans, jobs, streams, packed
+ * output and cipher_inline.h stay variable-time. Set to 1 to enable.
+ */
+#ifndef CIPHER_CONSTANT_TIME
+#define CIPHER_CONSTANT_TIME 0
+#endif
+
 typedef enum {
+    CIPHER_BUSY = 2,            /* TX ring full, retry later (cipher_tx.h)     */
+    CIPHER_IN_PROGRESS = 1,     /* incremental job not finished (cipher_job.h) */
     CIPHER_SUCCESS = 0,
     CIPHER_ERROR_NULL_POINTER = -1,
     CIPHER_ERROR_INVALID_KEY = -2,
-    CIPHER_ERROR_INVALID_LENGTH = -3
+    CIPHER_ERROR_INVALID_LENGTH = -3,
+    CIPHER_ERROR_INVALID_TABLE = -4,
+    CIPHER_ERROR_INVALID_CHAR = -5,
+    CIPHER_ERROR_IO = -6        /* host file API (cipher_file.h) */
 } cipher_status_t;
 
+/**
+ * @brief A caller-owned buffer: `len` bytes starting at `data`.
+ *
+ * No terminator is implied. Used to describe the frames of a batch and
+ * the fragments of a scattered message.
+ */
+typedef struct {
+    char  *data;
+    size_t len;
+} cipher_span_t;
+
+/** Offset type of plan index tables; holds any offset below CIPHER_MAX_INPUT_LEN. */
+typedef uint16_t cipher_index_t;
+
+/**
+ * @brief Precomputed shift permutation for one (length, key) pair.
+ *
+ * Built by cipher_plan_init() into caller-provided storage of `len`
+ * cipher_index_t entries (a static array or a stack buffer); the library
+ * never allocates. The storage must outlive the plan.
+ */
+typedef struct {
+    cipher_index_t *index;  /**< index[j]: input offset of ciphertext byte j */
+    size_t          len;    /**< frame length the plan was built for          */
+    int             key;    /**< key the plan was built for                   */
+} cipher_plan_t;
+
+/** Number of (length, rotations) slots held by a cipher_key_t. */
+#ifndef CIPHER_KEY_SLOTS
+#define CIPHER_KEY_SLOTS 8U
+#endif
+
+/**
+ * @brief Prepared key: the key plus its reduced rotations for recently used
+ *        frame lengths.
+ *
+ * Only `key` modulo each half's length matters, so a handle keeps those
+ * rotations for up to CIPHER_KEY_SLOTS lengths (direct-mapped on
+ * len % CIPHER_KEY_SLOTS). A call with a length already in the handle does
+ * no key processing at all; a new length is reduced once and replaces the
+ * slot's previous one. About 6 bytes per slot, so it suits variable-length
+ * traffic where a cipher_plan_t per length would cost too much RAM.
+ * Treat as opaque.
+ */
+typedef struct {
+    int key;
+    struct {
+        cipher_index_t len;         /* 0xFFFF when unused */
+        cipher_index_t lower_rot;
+        cipher_index_t upper_rot;
+    } slot[CIPHER_KEY_SLOTS];
+} cipher_key_t;
+
+/**
+ * @brief Substitution context: forward and inverse direct maps of one table.
+ *
+ * Built once by cipher_ctx_init() from a caller-supplied table, so that a
+ * table can be rotated at run time without reflashing. Both directions cost
+ * a single load per byte. Bytes outside the table map to themselves.
+ * Treat the members as read-only; a context is never modified by the
+ * cipher functions and may be shared between callers.
+ */
+typedef struct {
+    unsigned char forward[256];  /**< plaintext byte -> ciphertext byte     */
+    unsigned char inverse[256];  /**< ciphertext byte -> plaintext byte     */
+    unsigned char span_lo;       /**< smallest symbol in the table          */
+    unsigned char span_hi;       /**< largest symbol in the table           */
+} cipher_ctx_t;
+
+/** Context of the built-in table; used by every function without a `ctx`. */
+extern const cipher_ctx_t cipher_default_ctx;
+
 /**
  * @brief Encrypt a null-terminated string in-place.
  *
@@ -63,6 +210,557 @@ cipher_status_t cipher_encrypt(char *str, int key);
  */
 cipher_status_t cipher_decrypt(char *str, int key);
 
+/**
+ * @brief Encrypt a length-delimited buffer in-place.
+ *
+ * Same transformation as cipher_encrypt(), applied to exactly `len` bytes.
+ * The buffer does not need to be null-terminated and is never scanned for
+ * a terminator; a `'\0'` inside the buffer is treated like any other
+ * character outside the substitution table.
+ *
+ * @param[in,out] buf   Buffer to encrypt in-place.
+ * @param[in]     len   Number of bytes in `buf` (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]     key   Number of shift iterations (must be > 0).
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_encrypt_buf(char *buf, size_t len, int key);
+
+/**
+ * @brief Decrypt a length-delimited buffer in-place.
+ *
+ * Reverses cipher_encrypt_buf() when called with the same length and key.
+ *
+ * @param[in,out] buf   Encrypted buffer to decrypt in-place.
+ * @param[in]     len   Number of bytes in `buf` (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]     key   Number of shift iterations used during encryption.
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_decrypt_buf(char *buf, size_t len, int key);
+
+/**
+ * @brief cipher_encrypt_buf() that rejects bytes outside the substitution
+ *        table instead of passing them through.
+ *
+ * The check is made by the substitution pass itself, so there is no extra
+ * traversal, and the call stops at the first bad byte. On error the buffer
+ * is left exactly as it was.
+ *
+ * @param[in,out] buf         Buffer to encrypt in-place.
+ * @param[in]     len         Number of bytes in `buf` (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]     key         Number of shift iterations (must be > 0).
+ * @param[out]    bad_offset  Optional (may be NULL); on
+ *                            CIPHER_ERROR_INVALID_CHAR receives the offset
+ *                            of the first byte outside the table.
+ * @return CIPHER_OK on success, CIPHER_ERROR_INVALID_CHAR, or another
+ *         negative cipher_status_t error code.
+ */
+cipher_status_t cipher_encrypt_buf_strict(char *buf, size_t len, int key,
+                                          size_t *bad_offset);
+
+/**
+ * @brief cipher_decrypt_buf() that rejects bytes outside the substitution
+ *        table; same rules as cipher_encrypt_buf_strict().
+ *
+ * `bad_offset` is an offset into the ciphertext as passed in.
+ */
+cipher_status_t cipher_decrypt_buf_strict(char *buf, size_t len, int key,
+                                          size_t *bad_offset);
+
+/**
+ * @brief Encrypt `len` bytes from `in` into a separate output buffer.
+ *
+ * Produces the same ciphertext as cipher_encrypt_buf() in a single
+ * traversal: each input byte is read once and its substituted value is
+ * written straight to its shifted position in `out`. `in` is not modified,
+ * so it may live in read-only memory.
+ *
+ * The buffers must not overlap, except that `in == out` is accepted and
+ * falls back to the in-place path.
+ *
+ * @param[in]  in    Plaintext, `len` bytes.
+ * @param[out] out   Destination for `len` bytes of ciphertext.
+ * @param[in]  len   Number of bytes (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]  key   Number of shift iterations (must be > 0).
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_encrypt_to(const char *in, char *out, size_t len, int key);
+
+/**
+ * @brief Decrypt `len` bytes from `in` into a separate output buffer.
+ *
+ * Out-of-place counterpart of cipher_decrypt_buf(); same buffer rules as
+ * cipher_encrypt_to().
+ *
+ * @param[in]  in    Ciphertext, `len` bytes.
+ * @param[out] out   Destination for `len` bytes of plaintext.
+ * @param[in]  len   Number of bytes (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]  key   Number of shift iterations used during encryption.
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_decrypt_to(const char *in, char *out, size_t len, int key);
+
+/**
+ * @brief cipher_encrypt_buf() with a 64-bit key (e.g. derived from a
+ *        device serial).
+ *
+ * The key is reduced modulo each half's length before any byte moves,
+ * with 32-bit arithmetic only, so every key costs the same as key = 1.
+ * For 1 <= key <= INT_MAX the output is identical to the int API, so
+ * existing ciphertext decrypts with the *64 functions and vice versa.
+ *
+ * @param[in,out] buf   Buffer to encrypt in-place.
+ * @param[in]     len   Number of bytes in `buf` (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]     key   Number of shift iterations (must be non-zero).
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_encrypt_buf64(char *buf, size_t len, uint64_t key);
+
+/** @brief cipher_decrypt_buf() with a 64-bit key; see cipher_encrypt_buf64(). */
+cipher_status_t cipher_decrypt_buf64(char *buf, size_t len, uint64_t key);
+
+/** @brief cipher_encrypt_to() with a 64-bit key; see cipher_encrypt_buf64(). */
+cipher_status_t cipher_encrypt_to64(const char *in, char *out, size_t len,
+                                    uint64_t key);
+
+/** @brief cipher_decrypt_to() with a 64-bit key; see cipher_encrypt_buf64(). */
+cipher_status_t cipher_decrypt_to64(const char *in, char *out, size_t len,
+                                    uint64_t key);
+
+/** @brief cipher_encrypt() with a 64-bit key; see cipher_encrypt_buf64(). */
+cipher_status_t cipher_encrypt64(char *str, uint64_t key);
+
+/** @brief cipher_decrypt() with a 64-bit key; see cipher_encrypt_buf64(). */
+cipher_status_t cipher_decrypt64(char *str, uint64_t key);
+
+/**
+ * @brief Encrypt an array of buffers in-place with one key.
+ *
+ * Each frame is processed exactly as by cipher_encrypt_buf(). The key is
+ * reduced once per distinct frame length in the batch rather than once per
+ * frame. A bad frame does not stop the batch; its status is recorded and
+ * the remaining frames are still processed.
+ *
+ * @param[in,out] frames  Array of `count` frame descriptors.
+ * @param[in]     count   Number of frames.
+ * @param[in]     key     Number of shift iterations (must be > 0).
+ * @param[out]    status  Optional array of `count` per-frame results
+ *                        (may be NULL).
+ * @return CIPHER_OK if every frame succeeded, CIPHER_ERROR_NULL_POINTER if
+ *         `frames` is NULL, otherwise the error of the first failing frame.
+ */
+cipher_status_t cipher_encrypt_batch(cipher_span_t *frames, size_t count,
+                                     int key, cipher_status_t *status);
+
+/**
+ * @brief Decrypt an array of buffers in-place with one key.
+ *
+ * Reverses cipher_encrypt_batch(); same status reporting.
+ *
+ * @param[in,out] frames  Array of `count` frame descriptors.
+ * @param[in]     count   Number of frames.
+ * @param[in]     key     Number of shift iterations used during encryption.
+ * @param[out]    status  Optional array of `count` per-frame results
+ *                        (may be NULL).
+ * @return CIPHER_OK if every frame succeeded, CIPHER_ERROR_NULL_POINTER if
+ *         `frames` is NULL, otherwise the error of the first failing frame.
+ */
+cipher_status_t cipher_decrypt_batch(cipher_span_t *frames, size_t count,
+                                     int key, cipher_status_t *status);
+
+/**
+ * @brief Encrypt `count` frames packed back to back in one blob.
+ *
+ * Frame i is in[offsets[i] .. offsets[i+1]-1], so `offsets` has
+ * `count + 1` entries (Arrow/numpy layout; offsets[0] need not be 0).
+ * Each frame is encrypted exactly as by cipher_encrypt_buf() into the same
+ * offsets of `out`. One foreign call covers a whole column: meant for
+ * FFI callers (ctypes, cffi) through libcipher.so (`make shared`). The key
+ * is reduced once per distinct frame length, as in cipher_encrypt_batch().
+ *
+ * @param[in]  in       Input blob.
+ * @param[in]  offsets  `count + 1` non-decreasing frame boundaries.
+ * @param[in]  count    Number of frames.
+ * @param[out] out      Output blob, at least offsets[count] bytes; may be
+ *                      `in` itself (in place) but must not partially
+ *                      overlap it.
+ * @param[in]  key      Number of shift iterations (must be > 0).
+ * @param[out] status   Optional array of `count` per-frame results (may be
+ *                      NULL). The bytes of a failing frame in `out` are not
+ *                      written.
+ * @return CIPHER_OK if every frame succeeded, CIPHER_ERROR_NULL_POINTER if a
+ *         blob or `offsets` is NULL, otherwise the error of the first
+ *         failing frame (CIPHER_ERROR_INVALID_LENGTH for decreasing offsets).
+ */
+cipher_status_t cipher_encrypt_bulk(const char *in, const size_t *offsets,
+                                    size_t count, char *out, int key,
+                                    cipher_status_t *status);
+
+/**
+ * @brief Decrypt `count` frames packed back to back in one blob.
+ *
+ * Reverses cipher_encrypt_bulk(); same layout and status reporting.
+ */
+cipher_status_t cipher_decrypt_bulk(const char *in, const size_t *offsets,
+                                    size_t count, char *out, int key,
+                                    cipher_status_t *status);
+
+/**
+ * @brief Decrypt an Arrow string column in one sweep.
+ *
+ * Same as cipher_decrypt_bulk() over Arrow's buffers: `data` is the value
+ * buffer and `offsets` the int32 offsets buffer (`count + 1` entries,
+ * possibly starting above 0 for a sliced array). The plaintext lands at
+ * the same offsets of `out`, so the output column reuses `offsets` and
+ * the validity bitmap unchanged; null slots are empty frames. The next
+ * frame is prefetched while the current one is processed and the key is
+ * reduced once per distinct length.
+ *
+ * @param[in]  data     Value buffer of the ciphertext column.
+ * @param[in]  offsets  Arrow int32 offsets, non-negative and non-decreasing.
+ * @param[in]  count    Number of slots (array length).
+ * @param[out] out      Preallocated value buffer, at least offsets[count]
+ *                      bytes; may be `data` itself.
+ * @param[in]  key      Number of shift iterations used during encryption.
+ * @param[out] status   Optional array of `count` per-slot results.
+ * @return As cipher_decrypt_bulk(); a negative or decreasing offset fails
+ *         that slot with CIPHER_ERROR_INVALID_LENGTH.
+ */
+cipher_status_t cipher_decrypt_column(const char *data, const int32_t *offsets,
+                                      size_t count, char *out, int key,
+                                      cipher_status_t *status);
+
+/**
+ * @brief Encrypt an Arrow string column in one sweep.
+ *
+ * Inverse of cipher_decrypt_column(); same layout and status reporting.
+ */
+cipher_status_t cipher_encrypt_column(const char *data, const int32_t *offsets,
+                                      size_t count, char *out, int key,
+                                      cipher_status_t *status);
+
+/**
+ * @brief Encrypt a message held in several fragments, in place.
+ *
+ * The fragments are treated as one logical message, their concatenation:
+ * the midpoint and rotations come from the total length, and bytes move
+ * across fragment boundaries. The result in each fragment is exactly the
+ * corresponding slice of cipher_encrypt_buf() on the concatenation, with
+ * no copy into a contiguous buffer. Fragments may be empty but must not
+ * overlap.
+ *
+ * @code
+ *   cipher_span_t frame[3] = { { hdr, 8 }, { sensors, 48 }, { crc, 4 } };
+ *   cipher_encrypt_iov(frame, 3, key);
+ * @endcode
+ *
+ * @param[in] frags  Array of `count` fragment descriptors.
+ * @param[in] count  Number of fragments.
+ * @param[in] key    Number of shift iterations (must be > 0).
+ * @return CIPHER_OK on success, CIPHER_ERROR_NULL_POINTER if `frags` or a
+ *         fragment's data is NULL, CIPHER_ERROR_INVALID_KEY, or
+ *         CIPHER_ERROR_INVALID_LENGTH if the total exceeds
+ *         CIPHER_MAX_INPUT_LEN. Nothing is modified on error.
+ */
+cipher_status_t cipher_encrypt_iov(const cipher_span_t *frags, size_t count,
+                                   int key);
+
+/**
+ * @brief Decrypt a message held in several fragments, in place.
+ *
+ * Reverses cipher_encrypt_iov(). The fragmentation does not have to match
+ * the one used for encryption; only the total length matters.
+ *
+ * @param[in] frags  Array of `count` fragment descriptors.
+ * @param[in] count  Number of fragments.
+ * @param[in] key    Number of shift iterations used during encryption.
+ * @return Same codes as cipher_encrypt_iov().
+ */
+cipher_status_t cipher_decrypt_iov(const cipher_span_t *frags, size_t count,
+                                   int key);
+
+/**
+ * @brief Initialise a prepared key with no lengths cached.
+ *
+ * @param[out] handle  Handle to initialise.
+ * @param[in]  key     Number of shift iterations (must be > 0).
+ * @return CIPHER_OK, CIPHER_ERROR_NULL_POINTER or CIPHER_ERROR_INVALID_KEY.
+ */
+cipher_status_t cipher_key_init(cipher_key_t *handle, int key);
+
+/**
+ * @brief Reduce the key up front for a declared set of frame lengths.
+ *
+ * Lengths that share a slot (same len % CIPHER_KEY_SLOTS) evict each
+ * other; the last one listed is kept.
+ *
+ * @param[in,out] handle  Handle from cipher_key_init().
+ * @param[in]     lens    Array of `count` frame lengths.
+ * @param[in]     count   Number of lengths.
+ * @return CIPHER_OK, CIPHER_ERROR_NULL_POINTER, or
+ *         CIPHER_ERROR_INVALID_LENGTH if a length exceeds
+ *         CIPHER_MAX_INPUT_LEN (earlier lengths are still prepared).
+ */
+cipher_status_t cipher_key_prepare(cipher_key_t *handle, const size_t *lens,
+                                   size_t count);
+
+/**
+ * @brief cipher_encrypt_buf() with a prepared key.
+ *
+ * Learns `len` into the handle if it is not cached yet.
+ *
+ * @param[in,out] handle  Handle from cipher_key_init().
+ * @param[in,out] buf     Buffer to encrypt in-place.
+ * @param[in]     len     Number of bytes (at most CIPHER_MAX_INPUT_LEN).
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_key_encrypt_buf(cipher_key_t *handle, char *buf,
+                                       size_t len);
+
+/**
+ * @brief cipher_decrypt_buf() with a prepared key; same rules as
+ *        cipher_key_encrypt_buf(). Encryption and decryption share slots.
+ */
+cipher_status_t cipher_key_decrypt_buf(cipher_key_t *handle, char *buf,
+                                       size_t len);
+
+/**
+ * @brief Build a permutation plan for frames of `len` bytes under `key`.
+ *
+ * Example for fixed 64-byte frames:
+ * @code
+ *   static cipher_index_t idx64[64];
+ *   static cipher_plan_t  plan64;
+ *   cipher_plan_init(&plan64, idx64, 64, key);
+ * @endcode
+ *
+ * @param[out] plan     Plan to initialise.
+ * @param[in]  storage  At least `len` entries, owned by the caller.
+ * @param[in]  len      Frame length (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]  key      Number of shift iterations (must be > 0).
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_plan_init(cipher_plan_t *plan, cipher_index_t *storage,
+                                 size_t len, int key);
+
+/**
+ * @brief Encrypt one `plan->len`-byte frame with a plan (gather + substitute).
+ *
+ * Output is identical to cipher_encrypt_to() with the plan's length and key.
+ * `in` and `out` must not overlap, except that `in == out` falls back to the
+ * in-place path.
+ *
+ * @param[in]  plan  Plan from cipher_plan_init().
+ * @param[in]  in    Plaintext, `plan->len` bytes.
+ * @param[out] out   Destination for `plan->len` bytes of ciphertext.
+ * @return CIPHER_OK on success, or CIPHER_ERROR_NULL_POINTER.
+ */
+cipher_status_t cipher_plan_encrypt(const cipher_plan_t *plan,
+                                    const char *in, char *out);
+
+/**
+ * @brief Decrypt one `plan->len`-byte frame with a plan (scatter + substitute).
+ *
+ * Inverse of cipher_plan_encrypt(); same buffer rules.
+ *
+ * @param[in]  plan  Plan from cipher_plan_init() (same length and key).
+ * @param[in]  in    Ciphertext, `plan->len` bytes.
+ * @param[out] out   Destination for `plan->len` bytes of plaintext.
+ * @return CIPHER_OK on success, or CIPHER_ERROR_NULL_POINTER.
+ */
+cipher_status_t cipher_plan_decrypt(const cipher_plan_t *plan,
+                                    const char *in, char *out);
+
+/**
+ * @brief Build a substitution context from a table of (plaintext, ciphertext)
+ *        pairs.
+ *
+ * The table is accepted only if it is a bijection on its own symbol set:
+ * the plaintext column has no repeats, the ciphertext column has no repeats,
+ * both columns hold the same symbols, and no symbol maps to itself. On
+ * failure `ctx` is left unspecified and must not be used.
+ *
+ * @param[out] ctx    Context to initialise.
+ * @param[in]  table  CIPHER_TABLE_SIZE rows of {plaintext, ciphertext}.
+ * @return CIPHER_OK on success, CIPHER_ERROR_NULL_POINTER, or
+ *         CIPHER_ERROR_INVALID_TABLE.
+ */
+cipher_status_t cipher_ctx_init(cipher_ctx_t *ctx,
+                                const char table[CIPHER_TABLE_SIZE][2]);
+
+/**
+ * @brief cipher_encrypt_buf() through the maps of `ctx`.
+ *
+ * @param[in]     ctx   Context from cipher_ctx_init(), or &cipher_default_ctx.
+ * @param[in,out] buf   Buffer to encrypt in-place.
+ * @param[in]     len   Number of bytes in `buf` (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]     key   Number of shift iterations (must be > 0).
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_ctx_encrypt_buf(const cipher_ctx_t *ctx, char *buf,
+                                       size_t len, int key);
+
+/**
+ * @brief cipher_decrypt_buf() through the maps of `ctx`.
+ *
+ * @param[in]     ctx   Context the data was encrypted with.
+ * @param[in,out] buf   Encrypted buffer to decrypt in-place.
+ * @param[in]     len   Number of bytes in `buf` (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]     key   Number of shift iterations used during encryption.
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_ctx_decrypt_buf(const cipher_ctx_t *ctx, char *buf,
+                                       size_t len, int key);
+
+/**
+ * @brief cipher_encrypt_to() through the maps of `ctx`; same buffer rules.
+ */
+cipher_status_t cipher_ctx_encrypt_to(const cipher_ctx_t *ctx, const char *in,
+                                      char *out, size_t len, int key);
+
+/**
+ * @brief cipher_decrypt_to() through the maps of `ctx`; same buffer rules.
+ */
+cipher_status_t cipher_ctx_decrypt_to(const cipher_ctx_t *ctx, const char *in,
+                                      char *out, size_t len, int key);
+
+/**
+ * @brief Uppercase and encrypt a null-terminated string in one pass.
+ *
+ * Same result as cipher_to_uppercase() followed by cipher_encrypt(), but the
+ * case folding is folded into the substitution lookup, so the buffer is
+ * walked once by the substitution stage and no locale table is consulted.
+ * Only ASCII letters are folded.
+ *
+ * @param[in,out] str   Null-terminated string to encrypt in-place.
+ * @param[in]     key   Number of shift iterations (must be > 0).
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_encrypt_uppercase(char *str, int key);
+
+/**
+ * @brief Uppercase and encrypt a length-delimited buffer in one pass.
+ *
+ * Buffer counterpart of cipher_encrypt_uppercase(); same rules as
+ * cipher_encrypt_buf().
+ *
+ * @param[in,out] buf   Buffer to encrypt in-place.
+ * @param[in]     len   Number of bytes in `buf` (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]     key   Number of shift iterations (must be > 0).
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_encrypt_uppercase_buf(char *buf, size_t len, int key);
+
+/**
+ * @brief Free-running cycle counter used for stage timing.
+ *
+ * Typically reads DWT->CYCCNT on Cortex-M or `rdtsc` on a host. Only
+ * differences between two reads are used, so the counter may wrap.
+ */
+typedef uint32_t (*cipher_cycle_fn)(void);
+
+/**
+ * @brief Counters accumulated since the last cipher_stats_reset().
+ *
+ * Threading contract: every entry point adds to the counters of the
+ * thread that calls it, and cipher_stats_snapshot() / cipher_stats_reset()
+ * read and clear those of the calling thread. With CIPHER_STATS_PER_THREAD
+ * (hosts) each thread has its own set, so the cipher_mt.h workers and a
+ * cipher_tx.h consumer thread never race with the caller; their work is
+ * simply not in the caller's snapshot (the pool's plan caches are summed
+ * by cipher_mt_pool_plan_stats()). Without it there is one unsynchronised
+ * set: only call the library from one context at a time (e.g. not from
+ * both the main loop and a TX completion ISR) or the counts are
+ * unreliable. The library's results are correct either way.
+ */
+typedef struct {
+    uint32_t calls;          /**< entry-point calls, including failed ones   */
+    uint32_t errors;         /**< calls that returned an error               */
+    uint64_t bytes;          /**< bytes processed by successful calls        */
+    uint64_t shift_cycles;   /**< cycles in the split-shift stage            */
+    uint64_t subst_cycles;   /**< cycles in substitution (and in the fused
+                                  single-pass out-of-place kernels)          */
+    uint32_t plan_hits;      /**< plan cache lookups served from the cache  */
+    uint32_t plan_misses;    /**< plan cache lookups that built a plan      */
+    uint32_t plan_evictions; /**< plans dropped to make room (LRU)          */
+} cipher_stats_t;
+
+/**
+ * @brief Install the cycle counter (NULL, the default, disables timing).
+ *
+ * Without a counter the call, byte and error counters still run. Shared
+ * by all threads: install it before any other thread uses the library.
+ */
+void cipher_stats_set_clock(cipher_cycle_fn clock);
+
+/**
+ * @brief Copy the current counters to `snapshot` (all zero when the
+ *        library was built without CIPHER_ENABLE_STATS).
+ */
+void cipher_stats_snapshot(cipher_stats_t *snapshot);
+
+/** @brief Zero all counters. */
+void cipher_stats_reset(void);
+
+/**
+ * @brief In-place kernels that cipher_encrypt_buf() / cipher_decrypt_buf()
+ *        can dispatch to, per length bucket.
+ */
+typedef enum {
+    CIPHER_KERNEL_SCALAR = 0,   /**< three reversals + byte loop             */
+    CIPHER_KERNEL_SWAR   = 1,   /**< three reversals + 32-bit SWAR words     */
+    CIPHER_KERNEL_SIMD   = 2,   /**< three reversals + SSE/AVX2/NEON
+                                     (CIPHER_USE_SIMD builds only)           */
+    CIPHER_KERNEL_GATHER = 3,   /**< fused rotate + substitute into a stack
+                                     copy; frames up to 256 bytes, larger
+                                     ones fall back to the build default    */
+    CIPHER_KERNEL_COUNT
+} cipher_kernel_t;
+
+/** Length buckets: bucket b holds 2^b <= len < 2^(b+1) (and len 0 in bucket 0). */
+#define CIPHER_TUNE_BUCKETS 14U
+
+/**
+ * @brief Dispatch table: one cipher_kernel_t per length bucket.
+ *
+ * Usually filled by cipher_autotune(); a tuned table can be frozen as a
+ * const initializer (`make tune` prints one) and installed with
+ * cipher_tune_use(), so flash-only firmware never re-tunes.
+ */
+typedef struct {
+    unsigned char kernel[CIPHER_TUNE_BUCKETS];
+} cipher_tune_t;
+
+/**
+ * @brief Time every available kernel on this CPU and install the winners.
+ *
+ * For each length bucket, runs each kernel on a representative length
+ * (1.5 * 2^b bytes) in `scratch` and records the fastest in `table`, then
+ * makes `table` the active dispatch table. Buckets whose length exceeds
+ * `scratch_len` take the choice of the largest bucket measured. Call once
+ * at init, before any other thread uses the library: the active table is
+ * a plain global. No effect on dispatch in CIPHER_CONSTANT_TIME builds.
+ *
+ * @param[in]  clock        Monotonic counter (cycles or ticks; wraps freely).
+ * @param[out] scratch      Work buffer; its contents are overwritten.
+ * @param[in]  scratch_len  Size of `scratch` (clamped to CIPHER_MAX_INPUT_LEN).
+ * @param[out] table        Filled and installed; must outlive its use.
+ * @return CIPHER_OK, CIPHER_ERROR_NULL_POINTER, or
+ *         CIPHER_ERROR_INVALID_LENGTH if `scratch_len` is 0.
+ */
+cipher_status_t cipher_autotune(cipher_cycle_fn clock, char *scratch,
+                                size_t scratch_len, cipher_tune_t *table);
+
+/**
+ * @brief Install a dispatch table (e.g. a const one in flash).
+ *
+ * The table is referenced, not copied. NULL restores the build default
+ * (the kernel selected by CIPHER_USE_SIMD / CIPHER_USE_SWAR).
+ *
+ * @return CIPHER_OK, or CIPHER_ERROR_INVALID_TABLE (nothing installed) if an
+ *         entry names an unknown kernel or one this build lacks.
+ */
+cipher_status_t cipher_tune_use(const cipher_tune_t *table);
+
 /**
  * @brief Convert a string to uppercase in-place.
  *
@@ -0,0 +1,83 @@
+/**
+ * @file cipher_config.h
+ * @brief Build profiles: one switch that sets the speed/footprint knobs.
+ *
+ * Define at most one profile, on the compiler command line for the library
+ * and for every file that includes cipher.h (e.g. -DCIPHER_PROFILE_SIZE),
+ * or by uncommenting it below:
+ *
+ *   CIPHER_PROFILE_SIZE   16 KB-flash parts. In-place entry points search
+ *                         the 20-pair table instead of indexing the 256-byte
+ *                         direct maps, no SIMD or SWAR kernels, fewer key
+ *                         slots and a smaller stream scratch block.
+ *                         Build with -Os -ffunction-sections -fdata-sections
+ *                         and link with --gc-sections so unused entry points
+ *                         (and the maps) are dropped.
+ *   CIPHER_PROFILE_SPEED  Larger MCUs: direct maps, plans and the SWAR
+ *                         kernel; no SIMD.
+ *   CIPHER_PROFILE_HOST   Hosts and gateways: direct maps, plans and the
+ *                         SIMD kernels when the compiler targets them, and
+ *                         the threaded libcipher_mt.a (`make mt`).
+ *
+ * With no profile every knob keeps its own default (see cipher.h). A knob
+ * defined explicitly always wins over the profile. `make footprint` prints
+ * .text / .rodata / RAM for each profile.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#ifndef CIPHER_CONFIG_H
+#define CIPHER_CONFIG_H
+
+/* #define CIPHER_PROFILE_SIZE */
+/* #define CIPHER_PROFILE_SPEED */
+/* #define CIPHER_PROFILE_HOST */
+
+#if defined(CIPHER_PROFILE_SIZE) + defined(CIPHER_PROFILE_SPEED) + \
+    defined(CIPHER_PROFILE_HOST) > 1
+#error "cipher_config.h: define at most one CIPHER_PROFILE_*"
+#endif
+
+#if defined(CIPHER_PROFILE_SIZE)
+#ifndef CIPHER_USE_SIMD
+#define CIPHER_USE_SIMD 0
+#endif
+#ifndef CIPHER_USE_SWAR
+#define CIPHER_USE_SWAR 0
+#endif
+#ifndef CIPHER_USE_DIRECT_MAPS
+#define CIPHER_USE_DIRECT_MAPS 0
+#endif
+#ifndef CIPHER_KEY_SLOTS
+#define CIPHER_KEY_SLOTS 2U
+#endif
+#ifndef CIPHER_STREAM_BLOCK
+#define CIPHER_STREAM_BLOCK 16U
+#endif
+
+#elif defined(CIPHER_PROFILE_SPEED)
+#ifndef CIPHER_USE_SIMD
+#define CIPHER_USE_SIMD 0
+#endif
+#ifndef CIPHER_USE_SWAR
+#define CIPHER_USE_SWAR 1
+#endif
+
+#elif defined(CIPHER_PROFILE_HOST)
+#ifndef CIPHER_USE_SWAR
+#define CIPHER_USE_SWAR 0
+#endif
+/* CIPHER_USE_SIMD keeps its compiler-based default */
+#endif
+
+/*
+ * Substitution of the in-place default-table entry points (cipher_encrypt,
+ * cipher_decrypt, the _buf and *64 variants): 1 indexes the 256-byte
+ * direct maps through the tuned kernels; 0 searches the 20-pair table per
+ * byte, several times slower but it does not pull the maps, the kernels or
+ * the dispatch table into the image. Ignored in CIPHER_CONSTANT_TIME builds.
+ */
+#ifndef CIPHER_USE_DIRECT_MAPS
+#define CIPHER_USE_DIRECT_MAPS 1
+#endif
+
+#endif
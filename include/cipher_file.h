@@ -0,0 +1,103 @@
+/**
+ * @file cipher_file.h
+ * @brief Record-wise encrypt/decrypt of memory-mapped archive files.
+ *
+ * Host only: needs POSIX mmap, and is built into a separate archive
+ * (make archive -> libcipher_file.a, plus the cipher_archive CLI) so
+ * embedded builds of libcipher.a never pull it in. Link with
+ * -lcipher_file -lcipher.
+ *
+ * An archive is a sequence of records in one of two layouts:
+ *   - CIPHER_RECORDS_NEWLINE: records separated by '\n'; the last one may
+ *     be unterminated. The newlines themselves are not part of a record.
+ *   - CIPHER_RECORDS_LEN16: each record preceded by its length as a 16-bit
+ *     little-endian integer.
+ * Each record is one cipher_encrypt_buf() message. The framing bytes pass
+ * through unchanged, so the output has the same size and layout.
+ *
+ * The whole file is mapped once and records are processed straight in the
+ * mapping, in place or into a mapping of the output file: no read() or
+ * write() per record, no copy into a line buffer and no terminator. Both
+ * mappings are advised as sequential so kernel readahead runs ahead of the
+ * scan.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#ifndef CIPHER_FILE_H
+#define CIPHER_FILE_H
+
+#include "cipher.h"
+
+/** Record framing of an archive. */
+typedef enum {
+    CIPHER_RECORDS_NEWLINE = 0,
+    CIPHER_RECORDS_LEN16   = 1
+} cipher_record_format_t;
+
+/** Outcome of a record pass. */
+typedef struct {
+    size_t records;         /**< records found                               */
+    size_t failed;          /**< records left as they were                   */
+    size_t first_failed;    /**< byte offset of the first failed record's
+                                 data, or (size_t)-1 if none failed         */
+} cipher_records_report_t;
+
+/**
+ * @brief Encrypt every record of an archive held in memory.
+ *
+ * `out` receives the whole archive: encrypted records and unchanged framing.
+ * `in == out` processes in place; otherwise the buffers must not overlap.
+ * A record longer than CIPHER_MAX_INPUT_LEN, or a LEN16 record cut short by
+ * the end of the data, is copied unchanged and counted as failed; the pass
+ * carries on with the next record.
+ *
+ * @param[in]  in      Archive of `size` bytes.
+ * @param[out] out     Destination for `size` bytes.
+ * @param[in]  size    Archive size.
+ * @param[in]  key     Number of shift iterations (must be > 0).
+ * @param[in]  format  Record framing.
+ * @param[out] report  Optional (may be NULL).
+ * @return CIPHER_OK if every record succeeded, CIPHER_ERROR_NULL_POINTER,
+ *         CIPHER_ERROR_INVALID_KEY, or the error of the first failed record.
+ */
+cipher_status_t cipher_records_encrypt(const char *in, char *out, size_t size,
+                                       int key, cipher_record_format_t format,
+                                       cipher_records_report_t *report);
+
+/**
+ * @brief Decrypt every record of an archive held in memory.
+ *
+ * Inverse of cipher_records_encrypt(); same rules.
+ */
+cipher_status_t cipher_records_decrypt(const char *in, char *out, size_t size,
+                                       int key, cipher_record_format_t format,
+                                       cipher_records_report_t *report);
+
+/**
+ * @brief Encrypt every record of an archive file.
+ *
+ * @param[in]  in_path   Archive to read.
+ * @param[in]  out_path  File to create or truncate with the result, or NULL
+ *                       to rewrite `in_path` in place. A path naming the
+ *                       same file as `in_path` (same device and inode, e.g.
+ *                       through a link) is also rewritten in place.
+ * @param[in]  key       Number of shift iterations (must be > 0).
+ * @param[in]  format    Record framing.
+ * @param[out] report    Optional (may be NULL).
+ * @return As cipher_records_encrypt(), or CIPHER_ERROR_IO if a file could
+ *         not be opened, sized or mapped (errno is left set).
+ */
+cipher_status_t cipher_file_encrypt(const char *in_path, const char *out_path,
+                                    int key, cipher_record_format_t format,
+                                    cipher_records_report_t *report);
+
+/**
+ * @brief Decrypt every record of an archive file.
+ *
+ * Inverse of cipher_file_encrypt(); same rules.
+ */
+cipher_status_t cipher_file_decrypt(const char *in_path, const char *out_path,
+                                    int key, cipher_record_format_t format,
+                                    cipher_records_report_t *report);
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file cipher_inline.h
+ * @brief Header-only `static inline` cipher for compile-time keys and lengths.
+ *
+ * Firmware with a fixed provisioning key and fixed-size frames can use these
+ * instead of cipher_encrypt_to() / cipher_decrypt_to(). When `len` and `key`
+ * are compile-time constants the half lengths and reduced rotations fold to
+ * constants, every loop has a constant trip count and is fully unrolled, so
+ * a 64-byte frame becomes straight-line loads and stores through the direct
+ * map. Output is identical to the library functions.
+ *
+ * @code
+ *   #define FRAME_LEN 64
+ *   #define PROV_KEY  40503
+ *   cipher_status_t st;
+ *   CIPHER_ENCRYPT_FIXED(frame, FRAME_LEN, PROV_KEY, st);
+ *   if (st != CIPHER_OK) { ... }
+ * @endcode
+ *
+ * The direct maps are the library's own, so libcipher.a must still be linked.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#ifndef CIPHER_INLINE_H
+#define CIPHER_INLINE_H
+
+#include "cipher.h"
+
+#include <string.h>
+
+#if defined(__GNUC__)
+#define CIPHER_INLINE static inline __attribute__((always_inline))
+#else
+#define CIPHER_INLINE static inline
+#endif
+
+/* Ask for full unrolling of constant-trip-count loops where supported. */
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 8)
+#define CIPHER_UNROLL _Pragma("GCC unroll 1024")
+#else
+#define CIPHER_UNROLL
+#endif
+
+/**
+ * out[j] = map[in[(j + k) mod n]] for one half, as two constant-count loops.
+ */
+CIPHER_INLINE void cipher_inline_rotate_(const char *in, char *out,
+                                         size_t n, size_t k,
+                                         const unsigned char *map)
+{
+    size_t i;
+
+    CIPHER_UNROLL
+    for (i = k; i < n; i++) {
+        out[i - k] = (char)map[(unsigned char)in[i]];
+    }
+    CIPHER_UNROLL
+    for (i = 0; i < k; i++) {
+        out[n - k + i] = (char)map[(unsigned char)in[i]];
+    }
+}
+
+/**
+ * Shared body: split geometry and key reduction, then both halves.
+ * `decrypt` selects the inverse rotations and the reverse map.
+ */
+CIPHER_INLINE cipher_status_t cipher_inline_run_(const char *in, char *out,
+                                                 size_t len, int key,
+                                                 int decrypt)
+{
+    const size_t lower = (len + 1U) / 2U;
+    const size_t upper = len - lower;
+    size_t lower_rot = 0U;
+    size_t upper_rot = 0U;
+
+    if (in == NULL || out == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (key <= 0) {
+        return CIPHER_ERROR_INVALID_KEY;
+    }
+    if (len > CIPHER_MAX_INPUT_LEN) {
+        return CIPHER_ERROR_INVALID_LENGTH;
+    }
+
+    if (len >= 2U) {
+        lower_rot = (size_t)key % lower;
+        upper_rot = (size_t)key % upper;
+        if (decrypt) {
+            lower_rot = (lower - lower_rot) % lower;
+            upper_rot = (upper - upper_rot) % upper;
+        }
+    }
+
+    cipher_inline_rotate_(in, out, lower, lower_rot,
+                          decrypt ? cipher_default_ctx.inverse
+                                  : cipher_default_ctx.forward);
+    cipher_inline_rotate_(in + lower, out + lower, upper, upper_rot,
+                          decrypt ? cipher_default_ctx.inverse
+                                  : cipher_default_ctx.forward);
+    return CIPHER_SUCCESS;
+}
+
+/**
+ * @brief Inline out-of-place encrypt; same contract as cipher_encrypt_to()
+ *        except that `in` and `out` must not overlap at all.
+ */
+CIPHER_INLINE cipher_status_t cipher_encrypt_to_inline(const char *in, char *out,
+                                                       size_t len, int key)
+{
+    return cipher_inline_run_(in, out, len, key, 0);
+}
+
+/**
+ * @brief Inline out-of-place decrypt; same contract as cipher_decrypt_to()
+ *        except that `in` and `out` must not overlap at all.
+ */
+CIPHER_INLINE cipher_status_t cipher_decrypt_to_inline(const char *in, char *out,
+                                                       size_t len, int key)
+{
+    return cipher_inline_run_(in, out, len, key, 1);
+}
+
+/**
+ * @brief In-place encrypt of a `LEN`-byte buffer; `LEN` must be a
+ *        compile-time constant (it sizes a stack temporary).
+ *
+ * `STATUS` is a cipher_status_t lvalue that receives the result, as
+ * cipher_encrypt_to() would return it; on error `buf` is left unchanged.
+ */
+#define CIPHER_ENCRYPT_FIXED(buf, LEN, KEY, STATUS)                     \
+    do {                                                                \
+        char cipher_fixed_tmp_[(LEN) > 0 ? (LEN) : 1];                  \
+        (STATUS) = cipher_encrypt_to_inline((buf), cipher_fixed_tmp_,   \
+                                            (LEN), (KEY));              \
+        if ((STATUS) == CIPHER_SUCCESS) {                               \
+            memcpy((buf), cipher_fixed_tmp_, (LEN));                    \
+        }                                                               \
+    } while (0)
+
+/**
+ * @brief In-place decrypt of a `LEN`-byte buffer; same rules as
+ *        CIPHER_ENCRYPT_FIXED().
+ */
+#define CIPHER_DECRYPT_FIXED(buf, LEN, KEY, STATUS)                     \
+    do {                                                                \
+        char cipher_fixed_tmp_[(LEN) > 0 ? (LEN) : 1];                  \
+        (STATUS) = cipher_decrypt_to_inline((buf), cipher_fixed_tmp_,   \
+                                            (LEN), (KEY));              \
+        if ((STATUS) == CIPHER_SUCCESS) {                               \
+            memcpy((buf), cipher_fixed_tmp_, (LEN));                    \
+        }                                                               \
+    } while (0)
+
+#endif
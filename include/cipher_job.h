@@ -0,0 +1,78 @@
+/**
+ * @file cipher_job.h
+ * @brief Resumable in-place encryption with bounded work per call.
+ *
+ * A job does the same work as cipher_encrypt_buf() / cipher_decrypt_buf(),
+ * cut into steps of at most `budget` operations, so a main loop or
+ * scheduler tick can spread a large buffer over many calls:
+ *
+ * @code
+ *   static cipher_job_t job;
+ *   cipher_job_encrypt_init(&job, frame, len, key);
+ *   ...
+ *   // once per tick
+ *   if (cipher_job_step(&job, 256U) == CIPHER_SUCCESS) {
+ *       transmit(frame, len);
+ *   }
+ * @endcode
+ *
+ * One operation is one byte swap of the shift stage or one byte of the
+ * substitution stage, so the cost of a step is bounded by `budget` whatever
+ * the key. A whole job takes at most about 2 * len operations. The buffer
+ * holds intermediate state until the job completes and must not be touched
+ * in between. The context is small, fixed-size and never allocates.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#ifndef CIPHER_JOB_H
+#define CIPHER_JOB_H
+
+#include "cipher.h"
+
+/** Job context; treat as opaque, allocate statically or on the stack. */
+typedef struct {
+    char                *buf;
+    size_t               len;
+    size_t               lower;      /* length of the lower half        */
+    size_t               lower_rot;
+    size_t               upper_rot;
+    const unsigned char *map;
+    unsigned             phase;      /* current reversal / substitution */
+    size_t               lo;         /* cursors inside the phase        */
+    size_t               hi;
+} cipher_job_t;
+
+/**
+ * @brief Prepare to encrypt `len` bytes of `buf` in place.
+ *
+ * No work is done on the buffer until the first cipher_job_step().
+ *
+ * @param[out] job  Job to initialise.
+ * @param[in]  buf  Buffer to encrypt; must stay valid until the job is done.
+ * @param[in]  len  Number of bytes (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]  key  Number of shift iterations (must be > 0).
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_job_encrypt_init(cipher_job_t *job, char *buf,
+                                        size_t len, int key);
+
+/**
+ * @brief Prepare to decrypt `len` bytes of `buf` in place.
+ *
+ * Same parameters as cipher_job_encrypt_init().
+ */
+cipher_status_t cipher_job_decrypt_init(cipher_job_t *job, char *buf,
+                                        size_t len, int key);
+
+/**
+ * @brief Do at most `budget` operations of the job.
+ *
+ * @param[in,out] job     Job from one of the init functions.
+ * @param[in]     budget  Maximum operations for this call.
+ * @return CIPHER_SUCCESS once the buffer holds the final result (also on
+ *         any later call), CIPHER_IN_PROGRESS if work remains, or
+ *         CIPHER_ERROR_NULL_POINTER.
+ */
+cipher_status_t cipher_job_step(cipher_job_t *job, size_t budget);
+
+#endif
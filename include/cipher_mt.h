@@ -0,0 +1,98 @@
+/**
+ * @file cipher_mt.h
+ * @brief Multithreaded batch encrypt/decrypt for host-side bulk jobs.
+ *
+ * Host only: needs POSIX threads and the heap, and is built into a separate
+ * archive (make mt -> libcipher_mt.a) so embedded builds of libcipher.a
+ * never pull it in. Link with -lcipher_mt -lcipher -pthread.
+ *
+ * A pool splits a batch (see cipher_encrypt_batch()) across its workers.
+ * Every worker owns a queue holding a contiguous range of frames and takes
+ * small slices from its front; a worker whose queue runs dry steals the back
+ * half of another worker's queue, so batches with very uneven frame sizes
+ * still keep every core busy. The calling thread works as one of the pool's
+ * workers.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#ifndef CIPHER_MT_H
+#define CIPHER_MT_H
+
+#include "cipher.h"
+#include "cipher_plan_cache.h"
+
+/** Frames a worker takes from its own queue at a time. */
+#ifndef CIPHER_MT_GRAIN
+#define CIPHER_MT_GRAIN 16U
+#endif
+
+/** Opaque worker pool. */
+typedef struct cipher_mt_pool cipher_mt_pool_t;
+
+/**
+ * @brief Start a worker pool.
+ *
+ * @param[in] threads  Total workers including the calling thread; 0 uses
+ *                     the number of online CPUs.
+ * @return The pool, or NULL if threads or memory could not be obtained.
+ */
+cipher_mt_pool_t *cipher_mt_pool_create(unsigned threads);
+
+/**
+ * @brief Stop the workers and free the pool. NULL is ignored.
+ */
+void cipher_mt_pool_destroy(cipher_mt_pool_t *pool);
+
+/**
+ * @brief Decrypt a batch in-place across the pool.
+ *
+ * Results are identical to cipher_decrypt_batch() on the same arguments,
+ * including per-frame status and the return value. A pool runs one batch
+ * at a time; do not call this concurrently on the same pool.
+ *
+ * @param[in]     pool    Pool from cipher_mt_pool_create().
+ * @param[in,out] frames  Array of `count` frame descriptors.
+ * @param[in]     count   Number of frames.
+ * @param[in]     key     Number of shift iterations used during encryption.
+ * @param[out]    status  Optional array of `count` per-frame results.
+ * @return CIPHER_OK if every frame succeeded, CIPHER_ERROR_NULL_POINTER if
+ *         `pool` or `frames` is NULL, otherwise the error of the first
+ *         failing frame (lowest index).
+ */
+cipher_status_t cipher_mt_decrypt_batch(cipher_mt_pool_t *pool,
+                                        cipher_span_t *frames, size_t count,
+                                        int key, cipher_status_t *status);
+
+/**
+ * @brief Encrypt a batch in-place across the pool.
+ *
+ * Same contract as cipher_mt_decrypt_batch(), with cipher_encrypt_batch()
+ * semantics.
+ */
+cipher_status_t cipher_mt_encrypt_batch(cipher_mt_pool_t *pool,
+                                        cipher_span_t *frames, size_t count,
+                                        int key, cipher_status_t *status);
+
+/**
+ * @brief Give every worker a private plan cache (see cipher_plan_cache.h).
+ *
+ * Later batches on the pool run each frame through its worker's cache:
+ * no cache is shared, so the hot path takes no lock. Each frame is
+ * gathered through its plan into a per-worker CIPHER_MAX_INPUT_LEN
+ * scratch buffer and copied back. Results stay identical to the batch API. Replaces any caches set earlier (and their
+ * counters); 0 turns caching off. Not while a batch is running.
+ *
+ * @param[in] pool       Pool from cipher_mt_pool_create().
+ * @param[in] arena_len  Arena entries (cipher_index_t) per worker.
+ * @return CIPHER_OK, or CIPHER_ERROR_NULL_POINTER if `pool` is NULL or
+ *         memory could not be obtained (caching is then off).
+ */
+cipher_status_t cipher_mt_pool_plan_cache(cipher_mt_pool_t *pool, size_t arena_len);
+
+/**
+ * @brief Sum of the workers' plan cache counters (zero when caching is off).
+ */
+void cipher_mt_pool_plan_stats(const cipher_mt_pool_t *pool,
+                               cipher_plan_cache_stats_t *snapshot);
+
+#endif
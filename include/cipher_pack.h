@@ -0,0 +1,96 @@
+/**
+ * @file cipher_pack.h
+ * @brief Packed wire format: ciphertext at 13 bits per 3 symbols.
+ *
+ * Ciphertext over the built-in alphabet uses only 20 byte values, so
+ * sending it one symbol per byte wastes almost half of every byte. The
+ * packed format encodes each symbol as its code 0..19 (the rank of the
+ * symbol in byte order, `,0123456789:;=ABCDEF`) and packs groups of three
+ * codes as one base-20 number c0 + 20*c1 + 400*c2 < 8000 in 13 bits, about
+ * 4.33 bits per symbol. A trailing group of two codes takes 9 bits, a
+ * single code 5 bits. The groups form one bit stream, least significant
+ * bit first, zero-padded to a whole byte.
+ *
+ * The symbol count is not part of the stream; it travels out of band
+ * (frame header), exactly as the key does. A 64-symbol frame packs into
+ * CIPHER_PACKED_SIZE(64) == 35 bytes.
+ *
+ * cipher_encrypt_packed() / cipher_decrypt_packed() fuse the cipher with
+ * the packing: ciphertext bytes are never materialised, each plaintext byte
+ * is read once and each code is packed in ciphertext order.
+ *
+ * Only the built-in table is supported.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#ifndef CIPHER_PACK_H
+#define CIPHER_PACK_H
+
+#include "cipher.h"
+
+/** Bytes of packed output for `len` symbols. */
+#define CIPHER_PACKED_SIZE(len)                                            \
+    ((13U * ((len) / 3U) + (((len) % 3U) != 0U ? 4U * ((len) % 3U) + 1U : 0U) \
+      + 7U) / 8U)
+
+/**
+ * @brief Pack `len` ciphertext symbols.
+ *
+ * @param[in]  in   Ciphertext, `len` bytes, every byte in the alphabet.
+ * @param[in]  len  Number of symbols.
+ * @param[out] out  CIPHER_PACKED_SIZE(len) bytes.
+ * @return CIPHER_OK, CIPHER_ERROR_NULL_POINTER, or CIPHER_ERROR_INVALID_CHAR
+ *         if a byte is outside the alphabet (`out` is then unspecified).
+ */
+cipher_status_t cipher_pack(const char *in, size_t len, unsigned char *out);
+
+/**
+ * @brief Unpack `len` ciphertext symbols produced by cipher_pack().
+ *
+ * @param[in]  in   CIPHER_PACKED_SIZE(len) bytes.
+ * @param[in]  len  Number of symbols.
+ * @param[out] out  Destination for `len` bytes of ciphertext.
+ * @return CIPHER_OK, CIPHER_ERROR_NULL_POINTER, or CIPHER_ERROR_INVALID_CHAR
+ *         if a group decodes to a value no symbols could produce (`out` is
+ *         then unspecified).
+ */
+cipher_status_t cipher_unpack(const unsigned char *in, size_t len, char *out);
+
+/**
+ * @brief Encrypt `len` bytes and pack the ciphertext in one pass.
+ *
+ * Equivalent to cipher_encrypt_to() followed by cipher_pack(), without the
+ * intermediate buffer. `in` is not modified.
+ *
+ * @param[in]  in   Plaintext, `len` bytes, every byte in the alphabet.
+ * @param[in]  len  Number of bytes (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]  key  Number of shift iterations (must be > 0).
+ * @param[out] out  CIPHER_PACKED_SIZE(len) bytes.
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code;
+ *         CIPHER_ERROR_INVALID_CHAR if a byte is outside the alphabet.
+ *         Argument errors (NULL, key, length) leave `out` untouched; after
+ *         CIPHER_ERROR_INVALID_CHAR its contents are unspecified, since the
+ *         input is validated as it is packed, not in a separate pass.
+ */
+cipher_status_t cipher_encrypt_packed(const char *in, size_t len, int key,
+                                      unsigned char *out);
+
+/**
+ * @brief Unpack and decrypt `len` symbols in one pass.
+ *
+ * Inverse of cipher_encrypt_packed(); equivalent to cipher_unpack()
+ * followed by cipher_decrypt_to().
+ *
+ * @param[in]  in   CIPHER_PACKED_SIZE(len) bytes.
+ * @param[in]  len  Number of symbols (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]  key  Number of shift iterations used during encryption.
+ * @param[out] out  Destination for `len` bytes of plaintext.
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code;
+ *         CIPHER_ERROR_INVALID_CHAR if a group decodes to a value no
+ *         symbols could produce. Same rules for `out` on error as
+ *         cipher_encrypt_packed().
+ */
+cipher_status_t cipher_decrypt_packed(const unsigned char *in, size_t len,
+                                      int key, char *out);
+
+#endif
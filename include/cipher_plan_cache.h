@@ -0,0 +1,116 @@
+/**
+ * @file cipher_plan_cache.h
+ * @brief Bounded cache of shift plans keyed by (length, key).
+ *
+ * Building a cipher_plan_t costs a pass over its index table, which eats
+ * the gain of the plan when every frame length is seen only a few times.
+ * The cache keeps up to CIPHER_PLAN_CACHE_ENTRIES plans whose index
+ * tables live in an arena the caller provides (static RAM, a stack buffer
+ * or heap); the library never allocates. When either the arena or the
+ * entry table is full, the least recently used plans are evicted and the
+ * arena is compacted, so mixed lengths never fragment it.
+ *
+ * A cache is not thread-safe: give every thread its own (cipher_mt.h does
+ * this per worker). Hits, misses and evictions are counted per cache and,
+ * with CIPHER_ENABLE_STATS, in the calling thread's cipher_stats_snapshot()
+ * as well.
+ *
+ * @code
+ *   static cipher_index_t     arena[16384];     // 32 KB
+ *   static cipher_plan_cache_t cache;
+ *
+ *   cipher_plan_cache_init(&cache, arena, 16384);
+ *   cipher_plan_cache_decrypt(&cache, frame, plain, len, key);
+ * @endcode
+ *
+ * @author Rushikesh Kaduskar
+ */
+#ifndef CIPHER_PLAN_CACHE_H
+#define CIPHER_PLAN_CACHE_H
+
+#include "cipher.h"
+
+/** Maximum number of plans held at once, whatever the arena size. */
+#ifndef CIPHER_PLAN_CACHE_ENTRIES
+#define CIPHER_PLAN_CACHE_ENTRIES 64U
+#endif
+
+/** Counters of one cache since cipher_plan_cache_init(). */
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+} cipher_plan_cache_stats_t;
+
+/** Plan cache; treat as opaque. */
+typedef struct {
+    cipher_index_t *arena;
+    size_t          capacity;       /* arena size, in cipher_index_t    */
+    size_t          used;           /* entries in use, from arena start */
+    size_t          count;
+    uint32_t        clock;          /* ticks once per lookup            */
+    struct {
+        cipher_plan_t plan;         /* index points into the arena      */
+        uint32_t      last_use;
+    } entry[CIPHER_PLAN_CACHE_ENTRIES];     /* in arena order */
+    cipher_plan_cache_stats_t stats;
+} cipher_plan_cache_t;
+
+/**
+ * @brief Set up an empty cache over a caller-provided arena.
+ *
+ * A plan for `len` bytes takes `len` arena entries.
+ *
+ * @param[out] cache      Cache to initialise.
+ * @param[in]  arena      Storage for the plans' index tables; must outlive
+ *                        the cache.
+ * @param[in]  arena_len  Number of cipher_index_t entries in `arena`.
+ * @return CIPHER_OK, CIPHER_ERROR_NULL_POINTER, or
+ *         CIPHER_ERROR_INVALID_LENGTH if `arena_len` is 0.
+ */
+cipher_status_t cipher_plan_cache_init(cipher_plan_cache_t *cache,
+                                       cipher_index_t *arena, size_t arena_len);
+
+/**
+ * @brief Look up the plan for (`len`, `key`), building it on a miss.
+ *
+ * @param[in,out] cache  Cache from cipher_plan_cache_init().
+ * @param[in]     len    Frame length.
+ * @param[in]     key    Number of shift iterations (must be > 0).
+ * @param[out]    plan   The cached plan. Valid until the next lookup on
+ *                       this cache (a later miss may move or evict it).
+ * @return CIPHER_OK, CIPHER_ERROR_NULL_POINTER, CIPHER_ERROR_INVALID_KEY, or
+ *         CIPHER_ERROR_INVALID_LENGTH if the plan cannot fit the arena.
+ */
+cipher_status_t cipher_plan_cache_get(cipher_plan_cache_t *cache, size_t len,
+                                      int key, const cipher_plan_t **plan);
+
+/**
+ * @brief Encrypt `len` bytes from `in` to `out` through a cached plan.
+ *
+ * Output is identical to cipher_encrypt_to(). Frames too long for the
+ * arena are processed by cipher_encrypt_to() and counted as misses.
+ * `in` and `out` must not overlap, except that `in == out` is allowed.
+ *
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_plan_cache_encrypt(cipher_plan_cache_t *cache,
+                                          const char *in, char *out,
+                                          size_t len, int key);
+
+/**
+ * @brief Decrypt `len` bytes from `in` to `out` through a cached plan.
+ *
+ * Inverse of cipher_plan_cache_encrypt(); same buffer rules.
+ */
+cipher_status_t cipher_plan_cache_decrypt(cipher_plan_cache_t *cache,
+                                          const char *in, char *out,
+                                          size_t len, int key);
+
+/**
+ * @brief Copy the cache's hit / miss / eviction counters. NULL is ignored.
+ */
+void cipher_plan_cache_stats(const cipher_plan_cache_t *cache,
+                             cipher_plan_cache_stats_t *snapshot);
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file cipher_stream.h
+ * @brief Chunked encryption for payloads larger than CIPHER_MAX_INPUT_LEN.
+ *
+ * The split-shift midpoint depends on the total length, so a stream is
+ * created with that length up front and then fed the input in fragments of
+ * any size. Every input byte's output position is known as soon as it
+ * arrives, so output is emitted immediately through a callback as
+ * (offset, bytes) runs; the caller writes each run at its offset (flash,
+ * file, modem buffer). Nothing is buffered beyond one small block inside
+ * the context, so RAM use does not grow with the payload.
+ *
+ * Output runs are not emitted in offset order. Once every byte has been
+ * fed, the runs cover [0, total_len) exactly once, and the result is
+ * identical to cipher_encrypt_to() / cipher_decrypt_to() on the whole
+ * payload.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#ifndef CIPHER_STREAM_H
+#define CIPHER_STREAM_H
+
+#include "cipher.h"
+
+/** Size of the substitution scratch block held in each stream context. */
+#ifndef CIPHER_STREAM_BLOCK
+#define CIPHER_STREAM_BLOCK 32U
+#endif
+
+/**
+ * @brief Output callback: `len` bytes of output belong at `offset`.
+ *
+ * `data` is only valid for the duration of the call.
+ */
+typedef void (*cipher_stream_emit_fn)(void *user, size_t offset,
+                                      const char *data, size_t len);
+
+/** Stream context; treat as opaque, allocate statically or on the stack. */
+typedef struct {
+    size_t                total_len;
+    size_t                pos;          /* input bytes consumed so far */
+    size_t                lower;        /* length of the lower half    */
+    size_t                lower_rot;
+    size_t                upper_rot;
+    const unsigned char  *map;
+    cipher_stream_emit_fn emit;
+    void                 *user;
+    char                  block[CIPHER_STREAM_BLOCK];
+} cipher_stream_t;
+
+/**
+ * @brief Start encrypting a payload of `total_len` bytes.
+ *
+ * @param[out] stream     Context to initialise.
+ * @param[in]  total_len  Length of the whole payload (no upper limit).
+ * @param[in]  key        Number of shift iterations (must be > 0).
+ * @param[in]  emit       Output callback.
+ * @param[in]  user       Passed through to `emit`.
+ * @return CIPHER_OK on success, or a negative cipher_status_t error code.
+ */
+cipher_status_t cipher_stream_encrypt_init(cipher_stream_t *stream,
+                                           size_t total_len, int key,
+                                           cipher_stream_emit_fn emit,
+                                           void *user);
+
+/**
+ * @brief Start decrypting a payload of `total_len` bytes.
+ *
+ * Same parameters as cipher_stream_encrypt_init().
+ */
+cipher_status_t cipher_stream_decrypt_init(cipher_stream_t *stream,
+                                           size_t total_len, int key,
+                                           cipher_stream_emit_fn emit,
+                                           void *user);
+
+/**
+ * @brief Feed the next `len` bytes of input.
+ *
+ * @param[in,out] stream  Context from one of the init functions.
+ * @param[in]     chunk   Next input fragment.
+ * @param[in]     len     Fragment length.
+ * @return CIPHER_OK, CIPHER_ERROR_NULL_POINTER, or
+ *         CIPHER_ERROR_INVALID_LENGTH if the fragment would run past
+ *         `total_len` (nothing is consumed in that case).
+ */
+cipher_status_t cipher_stream_update(cipher_stream_t *stream,
+                                     const char *chunk, size_t len);
+
+/**
+ * @brief Check that the whole payload has been fed.
+ *
+ * @return CIPHER_OK if exactly `total_len` bytes were fed, otherwise
+ *         CIPHER_ERROR_INVALID_LENGTH (or CIPHER_ERROR_NULL_POINTER).
+ */
+cipher_status_t cipher_stream_final(const cipher_stream_t *stream);
+
+#endif
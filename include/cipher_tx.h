@@ -0,0 +1,107 @@
+/**
+ * @file cipher_tx.h
+ * @brief Encrypt-ahead ring for DMA-driven transmit paths.
+ *
+ * The application hands plaintext frames to cipher_tx_submit(), which
+ * encrypts each straight into the next free caller-owned slot with
+ * cipher_encrypt_to() and queues it. The link side is driven by two hooks:
+ * `start` is called to begin a DMA transfer of a queued slot, and the DMA
+ * transfer-complete ISR calls cipher_tx_complete(), which frees the slot
+ * and immediately starts the next queued one. While frame N is on the
+ * wire, frame N+1 is being encrypted; the link is restarted from the ISR
+ * without waiting for the application, and the application only ever
+ * waits (CIPHER_BUSY) when every slot is queued.
+ *
+ * @code
+ *   static char          bufs[2][FRAME_MAX];
+ *   static cipher_span_t slots[2] = { { bufs[0], 0 }, { bufs[1], 0 } };
+ *   static cipher_tx_t   tx;
+ *
+ *   cipher_tx_init(&tx, slots, 2, FRAME_MAX, key, uart_dma_start, &huart1);
+ *   ...
+ *   void DMA1_Stream6_IRQHandler(void) { ...; cipher_tx_complete(&tx); }
+ *   ...
+ *   while (cipher_tx_submit(&tx, frame, len) == CIPHER_BUSY) { idle(); }
+ * @endcode
+ *
+ * Ownership is lock-free single-producer/single-consumer: the producer
+ * (thread context) only writes `head` and `kicked`, the ISR only writes
+ * `tail` and `chained`, and no interrupt is ever masked. Exactly one
+ * transfer is in flight at a time. cipher_tx_submit() must be called from
+ * one context only, and cipher_tx_complete() from an ISR that can preempt
+ * it (same core). On cores with a data cache, `start` must clean the slot
+ * before handing it to the DMA.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#ifndef CIPHER_TX_H
+#define CIPHER_TX_H
+
+#include "cipher.h"
+
+/**
+ * @brief Begin transmitting `len` bytes at `data` (e.g. arm a UART DMA).
+ *
+ * Called from cipher_tx_submit() or from cipher_tx_complete(), i.e. from
+ * thread or interrupt context; must not block. `data` stays untouched
+ * until the matching cipher_tx_complete().
+ */
+typedef void (*cipher_tx_start_fn)(void *user, const char *data, size_t len);
+
+/** Pipeline context; treat as opaque, allocate statically. */
+typedef struct {
+    cipher_span_t      *slots;      /* caller buffers; .len set per frame   */
+    size_t              count;      /* number of slots, a power of two      */
+    size_t              capacity;   /* bytes per slot                       */
+    int                 key;
+    cipher_tx_start_fn  start;
+    void               *user;
+    volatile size_t     head;       /* frames queued          (producer)    */
+    volatile size_t     kicked;     /* transfers started by the producer    */
+    volatile size_t     tail;       /* frames sent            (ISR)         */
+    volatile size_t     chained;    /* transfers started by the ISR         */
+} cipher_tx_t;
+
+/**
+ * @brief Set up a pipeline over `count` caller-owned slots.
+ *
+ * @param[out] tx        Context to initialise.
+ * @param[in]  slots     `count` slots; `.data` points at `capacity` bytes
+ *                       each. The array must outlive the pipeline.
+ * @param[in]  count     Number of slots, a power of two (2 = double buffer).
+ * @param[in]  capacity  Bytes per slot (at most CIPHER_MAX_INPUT_LEN).
+ * @param[in]  key       Number of shift iterations (must be > 0).
+ * @param[in]  start     Transfer start hook.
+ * @param[in]  user      Passed through to `start`.
+ * @return CIPHER_OK on success, CIPHER_ERROR_NULL_POINTER,
+ *         CIPHER_ERROR_INVALID_KEY, or CIPHER_ERROR_INVALID_LENGTH for a bad
+ *         `count` or `capacity`.
+ */
+cipher_status_t cipher_tx_init(cipher_tx_t *tx, cipher_span_t *slots,
+                               size_t count, size_t capacity, int key,
+                               cipher_tx_start_fn start, void *user);
+
+/**
+ * @brief Encrypt `len` bytes of `frame` into the next free slot and queue it.
+ *
+ * Starts the link if it is idle. Never blocks.
+ *
+ * @param[in,out] tx     Pipeline from cipher_tx_init().
+ * @param[in]     frame  Plaintext; may be reused as soon as this returns.
+ * @param[in]     len    Frame length (at most the slot capacity).
+ * @return CIPHER_OK if queued, CIPHER_BUSY if every slot is still queued or
+ *         on the wire (nothing is done), or a negative cipher_status_t code.
+ */
+cipher_status_t cipher_tx_submit(cipher_tx_t *tx, const char *frame, size_t len);
+
+/**
+ * @brief Transfer-complete notification; call from the DMA ISR.
+ *
+ * Frees the slot just sent and starts the next queued one, if any.
+ */
+void cipher_tx_complete(cipher_tx_t *tx);
+
+/** @brief Frames queued or on the wire (0 once the ring has drained). */
+size_t cipher_tx_pending(const cipher_tx_t *tx);
+
+#endif
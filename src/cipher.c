@@ -7,6 +7,7 @@
  * @author Rushikesh Kaduskar
  */
 #include "cipher.h"
+#include "cipher_internal.h"
 
 #include <string.h>
 #include <ctype.h>
@@ -14,154 +15,1797 @@
 
 /**
 * Substitution Table:
-* Each row is a pair.
+* Each row is a (plaintext, ciphertext) pair.
 * Covers uppercase hex digits and four punctuation symbols.
+*
+* The pairs are listed once and expanded by the preprocessor into the
+* two direct maps below, so the maps cannot drift from the table.
 */
+#define SUBSTITUTION_PAIRS(X, v)                                    \
+    X(v, '0', 'B') X(v, '1', ';') X(v, '2', 'C') X(v, '3', 'D')     \
+    X(v, '4', ':') X(v, '5', 'F') X(v, '6', 'E') X(v, '7', '9')     \
+    X(v, '8', '3') X(v, '9', '8') X(v, 'A', '2') X(v, 'B', '4')     \
+    X(v, 'C', ',') X(v, 'D', '0') X(v, 'E', '=') X(v, 'F', '1')     \
+    X(v, ':', 'A') X(v, ',', '7') X(v, '=', '5') X(v, ';', '6')
 
-static const char SUBSTITUTION_TABLE[CIPHER_TABLE_SIZE][2] = {
-    {'0', 'B'}, {'1', ';'}, {'2', 'C'}, {'3', 'D'},
-    {'4', ':'}, {'5', 'F'}, {'6', 'E'}, {'7', '9'},
-    {'8', '3'}, {'9', '8'}, {'A', '2'}, {'B', '4'},
-    {'C', ','}, {'D', '0'}, {'E', '='}, {'F', '1'},
-    {':', 'A'}, {',', '7'}, {'=', '5'}, {';', '6'}
+/**
+* Direct maps:
+* 256-entry byte -> byte lookup tables, one per direction, built at
+* compile time as a chain of constant comparisons per entry. Bytes that
+* are not in the table map to themselves (pass-through).
+*/
+#define FORWARD_TERM(v, plain, enc) \
+    ((v) == (unsigned char)(plain)) ? (unsigned char)(enc) :
+#define REVERSE_TERM(v, plain, enc) \
+    ((v) == (unsigned char)(enc)) ? (unsigned char)(plain) :
+
+#define FORWARD_OF(v) (SUBSTITUTION_PAIRS(FORWARD_TERM, v) (unsigned char)(v))
+#define REVERSE_OF(v) (SUBSTITUTION_PAIRS(REVERSE_TERM, v) (unsigned char)(v))
+
+#define MAP_ROW(F, h)                                               \
+    F((h) + 0x0), F((h) + 0x1), F((h) + 0x2), F((h) + 0x3),         \
+    F((h) + 0x4), F((h) + 0x5), F((h) + 0x6), F((h) + 0x7),         \
+    F((h) + 0x8), F((h) + 0x9), F((h) + 0xA), F((h) + 0xB),         \
+    F((h) + 0xC), F((h) + 0xD), F((h) + 0xE), F((h) + 0xF)
+#define MAP_256(F)                                                  \
+    MAP_ROW(F, 0x00), MAP_ROW(F, 0x10), MAP_ROW(F, 0x20),           \
+    MAP_ROW(F, 0x30), MAP_ROW(F, 0x40), MAP_ROW(F, 0x50),           \
+    MAP_ROW(F, 0x60), MAP_ROW(F, 0x70), MAP_ROW(F, 0x80),           \
+    MAP_ROW(F, 0x90), MAP_ROW(F, 0xA0), MAP_ROW(F, 0xB0),           \
+    MAP_ROW(F, 0xC0), MAP_ROW(F, 0xD0), MAP_ROW(F, 0xE0),           \
+    MAP_ROW(F, 0xF0)
+
+
+/**
+* Case-folding forward map:
+* FOLD_FORWARD_MAP[b] == cipher_forward_map[toupper(b)] for the ASCII
+* letters, so one lookup does cipher_to_uppercase() and the substitution.
+* Non-identity entries span [ALPHABET_LO .. 'z'].
+*/
+#define UPPER_OF(v)        (((v) >= 'a' && (v) <= 'z') ? (v) - ('a' - 'A') : (v))
+#define FOLD_FORWARD_OF(v) FORWARD_OF(UPPER_OF(v))
+
+static const unsigned char FOLD_FORWARD_MAP[256] = { MAP_256(FOLD_FORWARD_OF) };
+
+#define FOLD_HI ((unsigned)'z')
+
+/* Smallest and largest symbol of the built-in alphabet (',' and 'F'),
+ * in both columns; every byte outside this range passes through. */
+#define ALPHABET_LO 0x2CU
+#define ALPHABET_HI 0x46U
+
+#define SPAN_TERM(v, plain, enc)                                    \
+    && (plain) >= ALPHABET_LO && (plain) <= ALPHABET_HI              \
+    && (enc) >= ALPHABET_LO && (enc) <= ALPHABET_HI
+typedef char alphabet_span_ok_t[(1 SUBSTITUTION_PAIRS(SPAN_TERM, ~)) ? 1 : -1];
+
+const cipher_ctx_t cipher_default_ctx = {
+    { MAP_256(FORWARD_OF) },
+    { MAP_256(REVERSE_OF) },
+    ALPHABET_LO,
+    ALPHABET_HI
 };
 
 /*-------------------------------------------------------------
 Validate input parameters 
 *-------------------------------------------------------------*/
-static cipher_status_t validate_arg(const char *str, int key) {
-    if (str == NULL) {
+static cipher_status_t validate_arg64(const char *buf, size_t len,
+                                      uint64_t key) {
+    if (buf == NULL) {
         return CIPHER_ERROR_NULL_POINTER;
     }
-    if (key <= 0) {
+    if (key == 0U) {
         return CIPHER_ERROR_INVALID_KEY;
     }
-    if (strlen(str) > CIPHER_MAX_INPUT_LEN) {
+    if (len > CIPHER_MAX_INPUT_LEN) {
         return CIPHER_ERROR_INVALID_LENGTH;
     }
     return CIPHER_SUCCESS;
 }
 
+/* int keys widen unchanged; keys <= 0 become 0, which is rejected */
+static uint64_t widen_key(int key)
+{
+    return key > 0 ? (uint64_t)key : 0U;
+}
+
+static cipher_status_t validate_arg(const char *buf, size_t len, int key) {
+    return validate_arg64(buf, len, widen_key(key));
+}
+
+/*-------------------------------------------------------------
+ * Length of a null-terminated string, scanning no further than
+ * one byte past CIPHER_MAX_INPUT_LEN. Anything longer is rejected
+ * by validate_arg() anyway, so there is no point walking it.
+*-------------------------------------------------------------*/
+static size_t bounded_strlen(const char *str)
+{
+    size_t len = 0U;
+
+    while (len <= CIPHER_MAX_INPUT_LEN && str[len] != '\0') {
+        len++;
+    }
+    return len;
+}
+
+/*-------------------------------------------------------------
+ * Instrumentation (CIPHER_ENABLE_STATS)
+ *
+ * STATS_MARK() starts a stage, STATS_STAGE(counter) books the
+ * cycles since the last mark to `counter` and starts the next
+ * stage, STATS_RESULT(status, len) counts the call and yields
+ * `status`. All three compile to nothing (or to `status`) when
+ * the option is off.
+*-------------------------------------------------------------*/
+#if CIPHER_ENABLE_STATS
+#if CIPHER_STATS_PER_THREAD
+#define STATS_LOCAL __thread        /* one set per thread, see cipher_stats_t */
+#else
+#define STATS_LOCAL
+#endif
+static STATS_LOCAL cipher_stats_t stats;
+static STATS_LOCAL uint32_t       stats_mark;
+static cipher_cycle_fn            stats_clock;
+
+static uint32_t stats_now(void)
+{
+    return (stats_clock != NULL) ? stats_clock() : 0U;
+}
+
+static void stats_stage(uint64_t *counter)
+{
+    uint32_t now = stats_now();
+
+    *counter  += (uint32_t)(now - stats_mark);  /* wraps with the counter */
+    stats_mark = now;
+}
+
+static cipher_status_t stats_result(cipher_status_t status, size_t len)
+{
+    stats.calls++;
+    if (status == CIPHER_SUCCESS) {
+        stats.bytes += len;
+    } else {
+        stats.errors++;
+    }
+    return status;
+}
+
+void cipher_stats_plan_cache(uint32_t hits, uint32_t misses, uint32_t evictions)
+{
+    stats.plan_hits      += hits;
+    stats.plan_misses    += misses;
+    stats.plan_evictions += evictions;
+}
+
+#define STATS_MARK()              ((void)(stats_mark = stats_now()))
+#define STATS_STAGE(counter)      stats_stage(&stats.counter)
+#define STATS_RESULT(status, len) stats_result((status), (len))
+#else
+#define STATS_MARK()              ((void)0)
+#define STATS_STAGE(counter)      ((void)0)
+#define STATS_RESULT(status, len) (status)
+#endif
+
 /*-------------------------------------------------------------
- * split-shift left
+ * Split geometry
  *
- * Performs one iteration of the split-shift used during encryption:
- *   - Left-rotates characters in the lower half  [0 .. mid-1]
- *   - Left-rotates characters in the upper half  [mid+1 .. len-1]
- * The midpoint character at index `mid` is left in place.
+ * The original single-step shift bubbled str[0] up to index
+ * mid = (len - 1) / 2, so the lower half includes the midpoint
+ * byte:
+ *   - lower half  [0 .. mid]        (len + 1) / 2 bytes
+ *   - upper half  [mid+1 .. len-1]  len / 2 bytes
+ * Each half is rotated independently, so only `key` modulo the
+ * half's length matters.
+*-------------------------------------------------------------*/
+static size_t lower_half_len(size_t len)
+{
+    return (len + 1U) / 2U;
+}
+
+/*-------------------------------------------------------------
+ * Reverse buf[lo .. hi-1] in place
 *-------------------------------------------------------------*/
-static void shift_left_once(char *str, int len) {
-    int mid = (len - 1) / 2;
-    int j;
+static void reverse_range(char *buf, size_t lo, size_t hi)
+{
     char temp;
 
-    /* Rotate lower half left by one position */
-    for (j = 0; j < mid; j++) {
-        temp      = str[j + 1];
-        str[j + 1] = str[j];
-        str[j]    = temp;
+    while (lo + 1U < hi) {
+        hi--;
+        temp    = buf[lo];
+        buf[lo] = buf[hi];
+        buf[hi] = temp;
+        lo++;
+    }
+}
+
+#if CIPHER_CONSTANT_TIME
+/*-------------------------------------------------------------
+ * Constant-time helpers (CIPHER_CONSTANT_TIME)
+ *
+ * Everything below runs a fixed instruction sequence for a given
+ * length: no branch and no memory address depends on the key or
+ * on the data. Operands are below 2^31 (keys are positive ints,
+ * lengths at most CIPHER_MAX_INPUT_LEN), so bit 31 of a
+ * difference is a borrow flag.
+*-------------------------------------------------------------*/
+#if SIZE_MAX > 0xFFFFFFFFU
+typedef uint64_t ct_word_t;         /* scan lanes: one per byte */
+#else
+typedef uint32_t ct_word_t;
+#endif
+
+#define CT_LANES sizeof(ct_word_t)
+#define CT_ONES  ((ct_word_t)-1 / 0xFFU)
+#define CT_LOW7  (CT_ONES * 0x7FU)
+#define CT_HIGH  (CT_ONES * 0x80U)
+
+/* x mod n by restoring division over all 32 bits of x */
+static size_t ct_mod(uint32_t x, size_t n)
+{
+    uint32_t d = (uint32_t)n;
+    uint32_t r = 0U;
+    int b;
+
+    for (b = 31; b >= 0; b--) {
+        r  = (r << 1) | ((x >> b) & 1U);
+        r -= d & (((r - d) >> 31) - 1U);    /* r >= d ? d : 0 */
+    }
+    return r;
+}
+
+/* All ones when x != 0, else 0 */
+static uint32_t ct_nonzero_mask(uint32_t x)
+{
+    return 0U - ((x | (0U - x)) >> 31);
+}
+
+/* Reverse buf[lo .. hi-1] when mask is 0xFF, leave it when 0 */
+static void reverse_range_masked(char *buf, size_t lo, size_t hi,
+                                 unsigned char mask)
+{
+    unsigned char *p = (unsigned char *)buf;
+    unsigned char t;
+
+    while (lo + 1U < hi) {
+        hi--;
+        t      = (unsigned char)((p[lo] ^ p[hi]) & mask);
+        p[lo] ^= t;
+        p[hi] ^= t;
+        lo++;
     }
+}
+
+/*-------------------------------------------------------------
+ * Left-rotate buf[0 .. n-1] by k positions (k < n), in place,
+ * in constant time: one masked rotation by 2^b for every bit b
+ * below n, applied or not according to bit b of k. Costs about
+ * n * log2(n) masked swaps whatever the value of k.
+*-------------------------------------------------------------*/
+static void rotate_left(char *buf, size_t n, size_t k)
+{
+    unsigned char mask;
+    size_t s;
+    unsigned b;
 
-    /* Rotate upper half left by one position */
-    for (j = mid + 1; j < len - 1; j++) {
-        temp       = str[j + 1];
-        str[j + 1] = str[j];
-        str[j]     = temp;
+    for (s = 1U, b = 0U; s < n; s <<= 1, b++) {
+        mask = (unsigned char)(0U - ((k >> b) & 1U));
+        reverse_range_masked(buf, 0U, s, mask);
+        reverse_range_masked(buf, s, n, mask);
+        reverse_range_masked(buf, 0U, n, mask);
     }
 }
 
 /*-------------------------------------------------------------
- * split-shift right (inverse of left shift)
+ * Substitute through a direct map by a masked scan of its span:
+ * each word of bytes is compared against every v in
+ * [lo, hi] and takes map[v] in the lanes that match. Bytes
+ * outside the span match nothing and pass through.
 *-------------------------------------------------------------*/
-static void shift_right_once(char *str, int len) {
-    int mid = (len - 1) / 2;
-    int j;
-    char temp;
+static void substitute_ct(char *buf, size_t len, const unsigned char map[256],
+                          unsigned lo, unsigned hi)
+{
+    unsigned char *p = (unsigned char *)buf;
+    ct_word_t x, y, out, m;
+    size_t i, j, n;
+    unsigned v;
+
+    for (i = 0; i < len; i += n) {
+        n = (len - i < CT_LANES) ? len - i : CT_LANES;
+        x = 0U;
+        for (j = 0; j < n; j++) {
+            x |= (ct_word_t)p[i + j] << (8U * j);
+        }
+        out = x;
+        for (v = lo; v <= hi; v++) {
+            y   = x ^ (CT_ONES * v);                    /* 0 lanes: match */
+            m   = ~(((y & CT_LOW7) + CT_LOW7) | y) & CT_HIGH;
+            m   = (m >> 7) * 0xFFU;
+            out = (out & ~m) | ((CT_ONES * map[v]) & m);
+        }
+        for (j = 0; j < n; j++) {
+            p[i + j] = (unsigned char)(out >> (8U * j));
+        }
+    }
+}
+#else
+/*-------------------------------------------------------------
+ * Left-rotate buf[0 .. n-1] by k positions (k < n), in place.
+ * Three reversals: one pass over the range whatever the value of k.
+*-------------------------------------------------------------*/
+static void rotate_left(char *buf, size_t n, size_t k)
+{
+    if (k == 0U) {
+        return;
+    }
+    reverse_range(buf, 0U, k);
+    reverse_range(buf, k, n);
+    reverse_range(buf, 0U, n);
+}
+#endif
+
+/*-------------------------------------------------------------
+ * key mod n, for n >= 1, without a 64-bit division
+ *
+ * With key = hi * 2^32 + lo, key mod n is
+ * ((hi mod n) * (2^32 mod n) + lo mod n) mod n, and 2^32 mod n is
+ * (2^32 - n) mod n. Below 2^16 the products fit in 32 bits, so a Cortex-M
+ * pays for a few 32-bit divides instead of a libgcc __aeabi_uldivmod call,
+ * and a wide key costs what an int key does. Only streams reach larger n.
+*-------------------------------------------------------------*/
+static size_t key_mod(uint64_t key, size_t n)
+{
+    uint32_t hi = (uint32_t)(key >> 32);
+    uint32_t lo = (uint32_t)key;
+
+    if (n > 0xFFFFU) {
+        return (size_t)(key % n);
+    }
+#if CIPHER_CONSTANT_TIME
+    return ct_mod((uint32_t)ct_mod(hi, n) * (uint32_t)ct_mod(0U - (uint32_t)n, n)
+                  + (uint32_t)ct_mod(lo, n), n);
+#else
+    if (hi == 0U) {
+        return lo % (uint32_t)n;
+    }
+    return ((hi % (uint32_t)n) * ((0U - (uint32_t)n) % (uint32_t)n)
+            + lo % (uint32_t)n) % (uint32_t)n;
+#endif
+}
+
+/*-------------------------------------------------------------
+ * Shift schedule (see cipher_internal.h)
+ *
+ * Buffers shorter than two bytes have nothing to rotate; the
+ * shift is the identity on them in both directions.
+*-------------------------------------------------------------*/
+void cipher_shift_schedule(cipher_shift_schedule_t *sched, size_t len,
+                           uint64_t key)
+{
+    sched->lower     = lower_half_len(len);
+    sched->lower_rot = 0U;
+    sched->upper_rot = 0U;
+    if (len >= 2U) {
+        sched->lower_rot = key_mod(key, sched->lower);
+        sched->upper_rot = key_mod(key, len - sched->lower);
+    }
+}
+
+/*-------------------------------------------------------------
+ * Turn an encryption schedule into the decryption one: a right
+ * rotation by r is a left rotation by (n - r) mod n.
+*-------------------------------------------------------------*/
+void cipher_shift_schedule_invert(cipher_shift_schedule_t *sched, size_t len)
+{
+#if CIPHER_CONSTANT_TIME
+    size_t upper = len - sched->lower;
+
+    sched->lower_rot = (sched->lower - sched->lower_rot) &
+                       ct_nonzero_mask((uint32_t)sched->lower_rot);
+    sched->upper_rot = (upper - sched->upper_rot) &
+                       ct_nonzero_mask((uint32_t)sched->upper_rot);
+#else
+    if (sched->lower_rot != 0U) {
+        sched->lower_rot = sched->lower - sched->lower_rot;
+    }
+    if (sched->upper_rot != 0U) {
+        sched->upper_rot = (len - sched->lower) - sched->upper_rot;
+    }
+#endif
+}
+
+/*-------------------------------------------------------------
+ * Apply a schedule in place
+*-------------------------------------------------------------*/
+static void apply_shift(char *buf, size_t len, const cipher_shift_schedule_t *sched)
+{
+    rotate_left(buf, sched->lower, sched->lower_rot);
+    rotate_left(buf + sched->lower, len - sched->lower, sched->upper_rot);
+}
+
+/*-------------------------------------------------------------
+ * split-shift left (encryption)
+ *
+ * Equivalent to `key` iterations of the single-step left shift.
+*-------------------------------------------------------------*/
+static void split_shift_left(char *str, size_t len, int key)
+{
+    cipher_shift_schedule_t sched;
+
+    cipher_shift_schedule(&sched, len, key);
+    apply_shift(str, len, &sched);
+}
+
+/*-------------------------------------------------------------
+ * split-shift right (inverse of split_shift_left)
+*-------------------------------------------------------------*/
+static void split_shift_right(char *str, size_t len, int key)
+{
+    cipher_shift_schedule_t sched;
+
+    cipher_shift_schedule(&sched, len, key);
+    cipher_shift_schedule_invert(&sched, len);
+    apply_shift(str, len, &sched);
+}
+
+/* -------------------------------------------------------------------------
+ * SWAR substitution (32-bit words)
+ *
+ * SWAR_HAS_BETWEEN(x, m, n) is non-zero when some byte b of x has
+ * m < b < n (valid for m <= 127, n <= 128). The map must be the identity
+ * outside [lo, hi]; words without a byte in that range are pure
+ * pass-through and are neither mapped nor written back. Spans outside
+ * 1 <= lo, hi <= 127 fall back to the byte loop.
+ * ---------------------------------------------------------------------- */
+#if defined(__GNUC__)
+typedef uint32_t __attribute__((__may_alias__)) swar_word_t;
+#else
+typedef uint32_t swar_word_t;
+#endif
+
+#define SWAR_ONES 0x01010101U
+#define SWAR_LOW7 0x7F7F7F7FU
+#define SWAR_HIGH 0x80808080U
+#define SWAR_HAS_BETWEEN(x, m, n)                                   \
+    (((SWAR_ONES * (127U + (n)) - ((x) & SWAR_LOW7)) & ~(x) &       \
+      (((x) & SWAR_LOW7) + SWAR_ONES * (127U - (m)))) & SWAR_HIGH)
 
-    /* Rotate upper half right by one position */
-    for (j = len - 1; j > mid; j--) {
-        temp       = str[j - 1];
-        str[j - 1] = str[j];
-        str[j]     = temp;
+static void substitute_swar(char *buf, size_t len, const unsigned char map[256],
+                            unsigned lo, unsigned hi)
+{
+    unsigned char *p   = (unsigned char *)buf;
+    unsigned char *end = p + len;
+    union {
+        uint32_t      w;
+        unsigned char b[4];
+    } word;
+
+    if (lo == 0U || hi > 127U) {
+        /* Span of a caller table too wide for SWAR_HAS_BETWEEN. */
+        while (p < end) {
+            *p = map[*p];
+            p++;
+        }
+        return;
+    }
+
+    while (p < end && ((uintptr_t)p & 3U) != 0U) {
+        *p = map[*p];
+        p++;
+    }
+    while (end - p >= 4) {
+        word.w = *(const swar_word_t *)(const void *)p;
+        if (SWAR_HAS_BETWEEN(word.w, lo - 1U, hi + 1U) != 0U) {
+            word.b[0] = map[word.b[0]];
+            word.b[1] = map[word.b[1]];
+            word.b[2] = map[word.b[2]];
+            word.b[3] = map[word.b[3]];
+            *(swar_word_t *)(void *)p = word.w;
+        }
+        p += 4;
     }
+    while (p < end) {
+        *p = map[*p];
+        p++;
+    }
+}
 
-    /* Rotate lower half right by one position */
-    for (j = mid + 1; j > 0; j--) {
-        temp       = str[j - 1];
-        str[j - 1] = str[j];
-        str[j]     = temp;
+/* Byte-at-a-time substitution through a direct map */
+static void substitute_bytes(char *buf, size_t len, const unsigned char map[256])
+{
+    size_t i;
+    for (i = 0; i < len; i++) {
+        buf[i] = (char)map[(unsigned char)buf[i]];
     }
 }
 
 /* -------------------------------------------------------------------------
- * forward substitution  (plaintext -> ciphertext)
+ * substitution through a direct map (one load per byte)
+ *
+ * `map` must be the identity outside [lo, hi]. Host builds hand the buffer
+ * to the vector kernels in cipher_simd.c; CIPHER_USE_SWAR selects the
+ * word-at-a-time kernel above and CIPHER_CONSTANT_TIME the masked scan.
  * ---------------------------------------------------------------------- */
-static void substitute_forward(char *str, int len)
+static void substitute_span(char *buf, size_t len, const unsigned char map[256],
+                            unsigned lo, unsigned hi)
 {
-    int i, a;
-    for (i = 0; i < len && str[i] != '\0'; i++) {
-        for (a = 0; a < (int)CIPHER_TABLE_SIZE; a++) {
-            if (SUBSTITUTION_TABLE[a][0] == str[i]) {
-                str[i] = SUBSTITUTION_TABLE[a][1];
-                break;
-            }
+#if CIPHER_CONSTANT_TIME
+    substitute_ct(buf, len, map, lo, hi);
+#elif CIPHER_USE_SIMD
+    (void)cipher_simd_substitute((unsigned char *)buf, len, map, lo, hi, 0);
+#elif CIPHER_USE_SWAR
+    substitute_swar(buf, len, map, lo, hi);
+#else
+    (void)lo;
+    (void)hi;
+    substitute_bytes(buf, len, map);
+#endif
+}
+
+/* Substitution through one of the built-in alphabet maps */
+static void substitute(char *buf, size_t len, const unsigned char map[256])
+{
+    substitute_span(buf, len, map, ALPHABET_LO, ALPHABET_HI);
+}
+
+/* -------------------------------------------------------------------------
+ * strict substitution
+ *
+ * The direct maps have no fixed points inside the alphabet, so a byte the
+ * map leaves unchanged is a byte outside it. Stops at the first such byte
+ * and returns its offset (or `len`): bytes before it are substituted, the
+ * rest of the buffer is untouched.
+ * ---------------------------------------------------------------------- */
+static size_t substitute_strict(char *buf, size_t len, const unsigned char map[256],
+                                unsigned lo, unsigned hi)
+{
+#if CIPHER_USE_SIMD
+    return cipher_simd_substitute((unsigned char *)buf, len, map, lo, hi, 1);
+#else
+    unsigned char *p = (unsigned char *)buf;
+    unsigned char c;
+    size_t i;
+
+    (void)lo;
+    (void)hi;
+    for (i = 0; i < len; i++) {
+        c = map[p[i]];
+        if (c == p[i]) {
+            break;
         }
+        p[i] = c;
     }
+    return i;
+#endif
 }
 
+#if !CIPHER_CONSTANT_TIME
 /* -------------------------------------------------------------------------
- * reverse substitution  (ciphertext -> plaintext)
+ * fused out-of-place rotate + substitute
+ *
+ * out[j] = map[in[(j + k) mod n]] for j in [0, n). Every input byte is
+ * read once, in order, and written once to its final position.
  * ---------------------------------------------------------------------- */
-static void substitute_reverse(char *str, int len)
+static void rotate_substitute(const char *in, char *out, size_t n, size_t k,
+                              const unsigned char map[256])
 {
-    int i, a;
-    for (i = 0; i < len && str[i] != '\0'; i++) {
-        for (a = 0; a < (int)CIPHER_TABLE_SIZE; a++) {
-            if (SUBSTITUTION_TABLE[a][1] == str[i]) {
-                str[i] = SUBSTITUTION_TABLE[a][0];
-                break;
+    size_t i;
+    for (i = k; i < n; i++) {
+        out[i - k] = (char)map[(unsigned char)in[i]];
+    }
+    for (i = 0; i < k; i++) {
+        out[n - k + i] = (char)map[(unsigned char)in[i]];
+    }
+}
+#endif
+
+/* -------------------------------------------------------------------------
+ * Apply a schedule and a map from `in` to `out` in one traversal
+ *
+ * The constant-time build copies first and runs the in-place kernels on
+ * `out`: the fused loop's read order depends on the rotation.
+ * ---------------------------------------------------------------------- */
+static void shift_substitute(const char *in, char *out, size_t len,
+                             const cipher_shift_schedule_t *sched,
+                             const unsigned char map[256],
+                             unsigned lo, unsigned hi)
+{
+#if CIPHER_CONSTANT_TIME
+    memcpy(out, in, len);
+    apply_shift(out, len, sched);
+    substitute_span(out, len, map, lo, hi);
+#else
+    size_t lower = sched->lower;
+
+    (void)lo;
+    (void)hi;
+    rotate_substitute(in, out, lower, sched->lower_rot, map);
+    rotate_substitute(in + lower, out + lower, len - lower,
+                      sched->upper_rot, map);
+#endif
+}
+
+/* -------------------------------------------------------------------------
+ * Kernel dispatch (cipher_autotune)
+ *
+ * The buffer entry points pick the kernel for the frame's length bucket
+ * from the active table. The built-in table selects the kernel
+ * substitute_span() uses, so an untuned library behaves as before.
+ * Constant-time builds never consult the table.
+ * ---------------------------------------------------------------------- */
+#if CIPHER_USE_SIMD
+#define TUNE_DEFAULT CIPHER_KERNEL_SIMD
+#elif CIPHER_USE_SWAR
+#define TUNE_DEFAULT CIPHER_KERNEL_SWAR
+#else
+#define TUNE_DEFAULT CIPHER_KERNEL_SCALAR
+#endif
+
+#define TUNE_GATHER_MAX  256U       /* stack copy of CIPHER_KERNEL_GATHER */
+#define TUNE_TRIAL_BYTES 4096U      /* bytes per timing trial             */
+#define TUNE_TRIALS      3U         /* best of                            */
+#define TUNE_KEY         40503      /* representative of production keys  */
+
+static const cipher_tune_t tune_default = { {
+    TUNE_DEFAULT, TUNE_DEFAULT, TUNE_DEFAULT, TUNE_DEFAULT, TUNE_DEFAULT,
+    TUNE_DEFAULT, TUNE_DEFAULT, TUNE_DEFAULT, TUNE_DEFAULT, TUNE_DEFAULT,
+    TUNE_DEFAULT, TUNE_DEFAULT, TUNE_DEFAULT, TUNE_DEFAULT
+} };
+
+typedef char tune_default_complete[(CIPHER_TUNE_BUCKETS == 14U) ? 1 : -1];
+
+static const cipher_tune_t *tune_active = &tune_default;
+
+#if !CIPHER_CONSTANT_TIME
+/* floor(log2(len)), clamped to the last bucket */
+static size_t tune_bucket(size_t len)
+{
+    size_t b = 0U;
+
+    while (len > 1U && b + 1U < CIPHER_TUNE_BUCKETS) {
+        len >>= 1;
+        b++;
+    }
+    return b;
+}
+#endif
+
+static int tune_available(unsigned kernel)
+{
+#if !CIPHER_USE_SIMD
+    if (kernel == CIPHER_KERNEL_SIMD) {
+        return 0;
+    }
+#endif
+    return kernel < CIPHER_KERNEL_COUNT;
+}
+
+/* Substitution stage of the shift-then-substitute kernels */
+static void tune_substitute(unsigned kernel, char *buf, size_t len,
+                            const unsigned char map[256], unsigned lo, unsigned hi)
+{
+    switch (kernel) {
+    case CIPHER_KERNEL_SCALAR:
+        substitute_bytes(buf, len, map);
+        break;
+    case CIPHER_KERNEL_SWAR:
+        substitute_swar(buf, len, map, lo, hi);
+        break;
+#if CIPHER_USE_SIMD
+    case CIPHER_KERNEL_SIMD:
+        (void)cipher_simd_substitute((unsigned char *)buf, len, map, lo, hi, 0);
+        break;
+#endif
+    default:
+        substitute_span(buf, len, map, lo, hi);
+        break;
+    }
+}
+
+/* CIPHER_KERNEL_GATHER: one fused pass into a stack copy, then back */
+static void tune_gather(char *buf, size_t len, const cipher_shift_schedule_t *sched,
+                        const unsigned char map[256], unsigned lo, unsigned hi)
+{
+    char copy[TUNE_GATHER_MAX];
+
+    shift_substitute(buf, copy, len, sched, map, lo, hi);
+    memcpy(buf, copy, len);
+}
+
+/* Shift + substitute `buf` in place with the kernel chosen for `len` */
+static void run_tuned(char *buf, size_t len, const cipher_shift_schedule_t *sched,
+                      const unsigned char map[256], unsigned lo, unsigned hi)
+{
+#if CIPHER_CONSTANT_TIME
+    apply_shift(buf, len, sched);                       //Stage 1: Shift
+    STATS_STAGE(shift_cycles);
+    substitute_span(buf, len, map, lo, hi);             //Stage 2: Substitution
+#else
+    unsigned kernel = tune_active->kernel[tune_bucket(len)];
+
+    if (kernel == CIPHER_KERNEL_GATHER && len <= TUNE_GATHER_MAX) {
+        tune_gather(buf, len, sched, map, lo, hi);      //Stage 1+2: Fused
+    } else {
+        apply_shift(buf, len, sched);                   //Stage 1: Shift
+        STATS_STAGE(shift_cycles);
+        tune_substitute(kernel, buf, len, map, lo, hi); //Stage 2: Substitution
+    }
+#endif
+    STATS_STAGE(subst_cycles);
+}
+
+/* Best-of-TUNE_TRIALS time of TUNE_TRIAL_BYTES worth of `kernel` calls */
+static uint32_t tune_time(cipher_cycle_fn clock, unsigned kernel, char *buf,
+                          size_t len, const cipher_shift_schedule_t *sched)
+{
+    size_t reps = TUNE_TRIAL_BYTES / len + 1U;
+    uint32_t best = UINT32_MAX;
+    uint32_t start, elapsed;
+    unsigned t;
+    size_t r;
+
+    for (t = 0; t < TUNE_TRIALS; t++) {
+        start = clock();
+        for (r = 0; r < reps; r++) {
+            if (kernel == CIPHER_KERNEL_GATHER) {
+                tune_gather(buf, len, sched, cipher_forward_map,
+                            ALPHABET_LO, ALPHABET_HI);
+            } else {
+                apply_shift(buf, len, sched);
+                tune_substitute(kernel, buf, len, cipher_forward_map,
+                                ALPHABET_LO, ALPHABET_HI);
             }
         }
+        elapsed = (uint32_t)(clock() - start);      /* wraps with the counter */
+        if (elapsed < best) {
+            best = elapsed;
+        }
     }
+    return best;
 }
 
 /* -------------------------------------------------------------------------
- * Public
+ * Schedule cache
+ *
+ * Direct-mapped on the buffer length, for one key and one direction.
+ * Callers that process many buffers with the same key reduce the key once
+ * per distinct length instead of once per buffer.
  * ---------------------------------------------------------------------- */
+#define SCHEDULE_CACHE_SLOTS 16U
+#define SCHEDULE_EMPTY       ((size_t)-1)
 
- cipher_status_t cipher_encrypt(char *str, int key)
+typedef struct {
+    int              key;
+    int              invert;
+    size_t           len[SCHEDULE_CACHE_SLOTS];
+    cipher_shift_schedule_t sched[SCHEDULE_CACHE_SLOTS];
+} schedule_cache_t;
+
+static void schedule_cache_init(schedule_cache_t *cache, int key, int invert)
 {
-    cipher_status_t status = validate_arg(str, key);
-    if (status != CIPHER_SUCCESS) {
-        return status;
+    size_t i;
+
+    cache->key    = key;
+    cache->invert = invert;
+    for (i = 0; i < SCHEDULE_CACHE_SLOTS; i++) {
+        cache->len[i] = SCHEDULE_EMPTY;
     }
+}
 
-    int len = (int)strlen(str);
-    int i;
+static const cipher_shift_schedule_t *schedule_cache_get(schedule_cache_t *cache,
+                                                  size_t len)
+{
+    size_t slot = len % SCHEDULE_CACHE_SLOTS;
 
-    for (i = 0; i < key; i++) {         //Stage 1: Shift
-        shift_left_once(str, len);
+    if (cache->len[slot] != len) {
+        cipher_shift_schedule(&cache->sched[slot], len, cache->key);
+        if (cache->invert) {
+            cipher_shift_schedule_invert(&cache->sched[slot], len);
+        }
+        cache->len[slot] = len;
     }
+    return &cache->sched[slot];
+}
 
-    substitute_forward(str, len);       //Stage 2: Substitution
-    return CIPHER_SUCCESS;
+/* -------------------------------------------------------------------------
+ * Prepared key slots (cipher_key_t)
+ *
+ * The slots store the encryption rotations; decryption inverts them with a
+ * subtraction, so both directions share one slot per length.
+ * ---------------------------------------------------------------------- */
+#define CIPHER_KEY_EMPTY ((cipher_index_t)0xFFFFU)
+
+typedef char key_empty_fits_t[(CIPHER_MAX_INPUT_LEN < 0xFFFFU) ? 1 : -1];
+
+static void key_learn(cipher_key_t *handle, size_t len)
+{
+    cipher_shift_schedule_t sched;
+    size_t slot = len % CIPHER_KEY_SLOTS;
+
+    cipher_shift_schedule(&sched, len, handle->key);
+    handle->slot[slot].len       = (cipher_index_t)len;
+    handle->slot[slot].lower_rot = (cipher_index_t)sched.lower_rot;
+    handle->slot[slot].upper_rot = (cipher_index_t)sched.upper_rot;
 }
 
-cipher_status_t cipher_decrypt(char *str, int key)
+static void key_schedule(cipher_key_t *handle, size_t len, int invert,
+                         cipher_shift_schedule_t *sched)
 {
-    cipher_status_t status = validate_arg(str, key);
+    size_t slot = len % CIPHER_KEY_SLOTS;
+
+    if (handle->slot[slot].len != (cipher_index_t)len) {
+        key_learn(handle, len);
+    }
+    sched->lower     = lower_half_len(len);
+    sched->lower_rot = handle->slot[slot].lower_rot;
+    sched->upper_rot = handle->slot[slot].upper_rot;
+    if (invert) {
+        cipher_shift_schedule_invert(sched, len);
+    }
+}
+
+static cipher_status_t run_key(cipher_key_t *handle, char *buf, size_t len,
+                               int decrypt)
+{
+    cipher_shift_schedule_t sched;
+    cipher_status_t status;
+
+    if (handle == NULL) {
+        return STATS_RESULT(CIPHER_ERROR_NULL_POINTER, 0U);
+    }
+    status = validate_arg(buf, len, handle->key);
     if (status != CIPHER_SUCCESS) {
-        return status;
+        return STATS_RESULT(status, 0U);
+    }
+
+    STATS_MARK();
+    key_schedule(handle, len, decrypt, &sched);
+    apply_shift(buf, len, &sched);                          //Stage 1: Shift
+    STATS_STAGE(shift_cycles);
+    substitute(buf, len,                                    //Stage 2: Substitution
+               decrypt ? cipher_reverse_map : cipher_forward_map);
+    STATS_STAGE(subst_cycles);
+    return STATS_RESULT(CIPHER_SUCCESS, len);
+}
+
+/* -------------------------------------------------------------------------
+ * Batch driver shared by cipher_encrypt_batch() / cipher_decrypt_batch()
+ * ---------------------------------------------------------------------- */
+static cipher_status_t run_batch(cipher_span_t *frames, size_t count, int key,
+                                 cipher_status_t *status, int decrypt)
+{
+    const unsigned char *map = decrypt ? cipher_reverse_map : cipher_forward_map;
+    cipher_status_t result = CIPHER_SUCCESS;
+    cipher_status_t frame_status;
+    schedule_cache_t cache;
+    size_t i;
+
+    if (frames == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+
+    schedule_cache_init(&cache, key, decrypt);
+    for (i = 0; i < count; i++) {
+        frame_status = validate_arg(frames[i].data, frames[i].len, key);
+        if (frame_status == CIPHER_SUCCESS) {
+            STATS_MARK();
+            apply_shift(frames[i].data, frames[i].len,
+                        schedule_cache_get(&cache, frames[i].len));
+            STATS_STAGE(shift_cycles);
+            substitute(frames[i].data, frames[i].len, map);
+            STATS_STAGE(subst_cycles);
+        } else if (result == CIPHER_SUCCESS) {
+            result = frame_status;
+        }
+        (void)STATS_RESULT(frame_status, frames[i].len);
+        if (status != NULL) {
+            status[i] = frame_status;
+        }
     }
+    return result;
+}
+
+/* -------------------------------------------------------------------------
+ * Flat bulk frames (cipher_*_bulk, cipher_*_column)
+ *
+ * Same per-frame handling as run_batch(), over an offsets array into one
+ * blob, in one forward sweep. Out-of-place frames take the fused
+ * single-pass kernel, which reads each half from its rotation point and
+ * then from its start: while a frame is processed, the start of both
+ * halves of the next one is prefetched, so the non-sequential streams do
+ * not stall the sweep.
+ * ---------------------------------------------------------------------- */
+#if defined(__GNUC__)
+#define PREFETCH(addr, rw) __builtin_prefetch((addr), (rw))
+#else
+#define PREFETCH(addr, rw) ((void)(addr))
+#endif
 
-    int len = (int)strlen(str);
-    int i;
+/* Exactly one of the two is set */
+typedef struct {
+    const size_t  *size;            /* cipher_*_bulk()              */
+    const int32_t *i32;             /* cipher_*_column() (Arrow)    */
+} bulk_offsets_t;
+
+/* Bounds of frame i; 0 if they are negative or decreasing */
+static int bulk_frame(const bulk_offsets_t *offsets, size_t i,
+                      size_t *off, size_t *len)
+{
+    if (offsets->i32 != NULL) {
+        int32_t lo = offsets->i32[i];
+        int32_t hi = offsets->i32[i + 1U];
 
-    for (i = 0; i < key; i++) {         //Stage 1: Inverse Shift
-        shift_right_once(str, len);
+        if (lo < 0 || hi < lo) {
+            return 0;
+        }
+        *off = (size_t)lo;
+        *len = (size_t)(hi - lo);
+        return 1;
+    }
+    if (offsets->size[i + 1U] < offsets->size[i]) {
+        return 0;
     }
+    *off = offsets->size[i];
+    *len = offsets->size[i + 1U] - *off;
+    return 1;
+}
 
-    substitute_reverse(str, len);       //Stage 2: Reverse Substitution
+static cipher_status_t run_bulk(const char *in, const bulk_offsets_t *offsets,
+                                size_t count, char *out, int key,
+                                cipher_status_t *status, int decrypt)
+{
+    const unsigned char *map = decrypt ? cipher_reverse_map : cipher_forward_map;
+    const cipher_shift_schedule_t *sched;
+    cipher_status_t result = CIPHER_SUCCESS;
+    cipher_status_t frame_status;
+    schedule_cache_t cache;
+    size_t i, off, len;
+
+    if (in == NULL || out == NULL ||
+        (offsets->size == NULL && offsets->i32 == NULL)) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+
+    schedule_cache_init(&cache, key, decrypt);
+    for (i = 0; i < count; i++) {
+        if (i + 1U < count && bulk_frame(offsets, i + 1U, &off, &len)) {
+            PREFETCH(in + off, 0);
+            PREFETCH(in + off + lower_half_len(len), 0);
+            PREFETCH(out + off, 1);
+        }
+
+        len = 0U;
+        frame_status = bulk_frame(offsets, i, &off, &len)
+                     ? validate_arg(in, len, key)
+                     : CIPHER_ERROR_INVALID_LENGTH;
+        if (frame_status == CIPHER_SUCCESS) {
+            STATS_MARK();
+            sched = schedule_cache_get(&cache, len);
+            if (in == out) {
+                apply_shift(out + off, len, sched);
+                STATS_STAGE(shift_cycles);
+                substitute(out + off, len, map);
+            } else {
+                shift_substitute(in + off, out + off, len, sched, map,
+                                 ALPHABET_LO, ALPHABET_HI);
+            }
+            STATS_STAGE(subst_cycles);
+        } else if (result == CIPHER_SUCCESS) {
+            result = frame_status;
+        }
+        (void)STATS_RESULT(frame_status, len);
+        if (status != NULL) {
+            status[i] = frame_status;
+        }
+    }
+    return result;
+}
+
+/* -------------------------------------------------------------------------
+ * Plan index table
+ *
+ * index[j] is the input offset whose byte lands at output offset j after
+ * the encryption shift. Offsets must fit in cipher_index_t.
+ * ---------------------------------------------------------------------- */
+typedef char plan_index_fits_t[(CIPHER_MAX_INPUT_LEN <= 0xFFFFU) ? 1 : -1];
+
+static void rotate_index(cipher_index_t *index, size_t base, size_t n, size_t k)
+{
+    size_t i;
+    for (i = k; i < n; i++) {
+        index[i - k] = (cipher_index_t)(base + i);
+    }
+    for (i = 0; i < k; i++) {
+        index[n - k + i] = (cipher_index_t)(base + i);
+    }
+}
+
+/* -------------------------------------------------------------------------
+ * Fragment lists
+ *
+ * An array of spans is one logical message. A cursor names one byte of it
+ * as (fragment, offset). The shift runs the same three reversals as
+ * rotate_left() on logical offsets, swapping through cursors that walk
+ * inwards across fragment boundaries; once both ends are inside the same
+ * fragment the rest is a plain reverse_range().
+ * ---------------------------------------------------------------------- */
+typedef struct {
+    const cipher_span_t *frag;
+    size_t               off;
+} frag_cursor_t;
+
+/* Cursor on logical offset `pos` (which must exist) */
+static frag_cursor_t frag_cursor_at(const cipher_span_t *frags, size_t pos)
+{
+    frag_cursor_t cur;
+
+    while (pos >= frags->len) {
+        pos -= frags->len;
+        frags++;
+    }
+    cur.frag = frags;
+    cur.off  = pos;
+    return cur;
+}
+
+/* Step to the next / previous byte, skipping empty fragments */
+static void frag_cursor_next(frag_cursor_t *cur)
+{
+    cur->off++;
+    while (cur->off == cur->frag->len) {
+        cur->frag++;
+        cur->off = 0U;
+    }
+}
+
+static void frag_cursor_prev(frag_cursor_t *cur)
+{
+    while (cur->off == 0U) {
+        cur->frag--;
+        cur->off = cur->frag->len;
+    }
+    cur->off--;
+}
+
+/* Reverse logical bytes [lo .. hi-1] of a fragment list */
+static void frag_reverse(const cipher_span_t *frags, size_t lo, size_t hi)
+{
+    frag_cursor_t left, right;
+    size_t swaps;
+    char temp;
+
+    if (lo + 1U >= hi) {
+        return;
+    }
+    left  = frag_cursor_at(frags, lo);
+    right = frag_cursor_at(frags, hi - 1U);
+    swaps = (hi - lo) / 2U;
+
+    while (left.frag != right.frag) {
+        temp = left.frag->data[left.off];
+        left.frag->data[left.off]   = right.frag->data[right.off];
+        right.frag->data[right.off] = temp;
+        if (--swaps == 0U) {
+            return;
+        }
+        frag_cursor_next(&left);
+        frag_cursor_prev(&right);
+    }
+    reverse_range(left.frag->data, left.off, right.off + 1U);
+}
+
+/* Left-rotate logical bytes [base .. base+n-1] by k (k < n) */
+static void frag_rotate_left(const cipher_span_t *frags, size_t base,
+                             size_t n, size_t k)
+{
+    if (k == 0U) {
+        return;
+    }
+    frag_reverse(frags, base, base + k);
+    frag_reverse(frags, base + k, base + n);
+    frag_reverse(frags, base, base + n);
+}
+
+/* -------------------------------------------------------------------------
+ * Fragment driver shared by cipher_encrypt_iov() / cipher_decrypt_iov()
+ * ---------------------------------------------------------------------- */
+static cipher_status_t run_iov(const cipher_span_t *frags, size_t count,
+                               int key, int decrypt)
+{
+    cipher_shift_schedule_t sched;
+    size_t total = 0U;
+    int too_long = 0;
+    size_t i;
+
+    if (frags == NULL) {
+        return STATS_RESULT(CIPHER_ERROR_NULL_POINTER, 0U);
+    }
+    for (i = 0; i < count; i++) {
+        if (frags[i].data == NULL) {
+            return STATS_RESULT(CIPHER_ERROR_NULL_POINTER, 0U);
+        }
+        if (frags[i].len > CIPHER_MAX_INPUT_LEN - total) {
+            too_long = 1;
+        } else {
+            total += frags[i].len;
+        }
+    }
+    if (key <= 0) {
+        return STATS_RESULT(CIPHER_ERROR_INVALID_KEY, 0U);
+    }
+    if (too_long) {
+        return STATS_RESULT(CIPHER_ERROR_INVALID_LENGTH, 0U);
+    }
+
+    STATS_MARK();
+    cipher_shift_schedule(&sched, total, key);
+    if (decrypt) {
+        cipher_shift_schedule_invert(&sched, total);
+    }
+    frag_rotate_left(frags, 0U, sched.lower, sched.lower_rot);  //Stage 1: Shift
+    frag_rotate_left(frags, sched.lower, total - sched.lower, sched.upper_rot);
+    STATS_STAGE(shift_cycles);
+    for (i = 0; i < count; i++) {                    //Stage 2: Substitution
+        substitute(frags[i].data, frags[i].len,
+                   decrypt ? cipher_reverse_map : cipher_forward_map);
+    }
+    STATS_STAGE(subst_cycles);
+    return STATS_RESULT(CIPHER_SUCCESS, total);
+}
+
+/* -------------------------------------------------------------------------
+ * Strict driver shared by cipher_encrypt_buf_strict() / _decrypt_buf_strict()
+ *
+ * The substitution is per byte and the shift only moves bytes, so the two
+ * stages commute: substituting first lets a bad byte stop the call before
+ * the shift has touched the buffer, and its offset is the caller's own.
+ * ---------------------------------------------------------------------- */
+static cipher_status_t run_strict(const cipher_ctx_t *ctx, char *buf,
+                                  size_t len, int key, size_t *bad_offset,
+                                  int decrypt)
+{
+    const unsigned char *map  = decrypt ? ctx->inverse : ctx->forward;
+    const unsigned char *undo = decrypt ? ctx->forward : ctx->inverse;
+    cipher_status_t status = validate_arg(buf, len, key);
+    size_t bad;
+
+    if (status != CIPHER_SUCCESS) {
+        return STATS_RESULT(status, 0U);
+    }
+
+    STATS_MARK();
+    bad = substitute_strict(buf, len, map,          //Stage 1: Substitution
+                            ctx->span_lo, ctx->span_hi);
+    if (bad < len) {
+        substitute_span(buf, bad, undo, ctx->span_lo, ctx->span_hi);
+        if (bad_offset != NULL) {
+            *bad_offset = bad;
+        }
+        return STATS_RESULT(CIPHER_ERROR_INVALID_CHAR, 0U);
+    }
+    STATS_STAGE(subst_cycles);
+    if (decrypt) {
+        split_shift_right(buf, len, key);           //Stage 2: Inverse Shift
+    } else {
+        split_shift_left(buf, len, key);            //Stage 2: Shift
+    }
+    STATS_STAGE(shift_cycles);
+    return STATS_RESULT(CIPHER_SUCCESS, len);
+}
+
+/* -------------------------------------------------------------------------
+ * Public
+ * ---------------------------------------------------------------------- */
+
+static cipher_status_t ctx_encrypt_buf64(const cipher_ctx_t *ctx, char *buf,
+                                        size_t len, uint64_t key)
+{
+    cipher_shift_schedule_t sched;
+    cipher_status_t status;
+
+    if (ctx == NULL) {
+        return STATS_RESULT(CIPHER_ERROR_NULL_POINTER, 0U);
+    }
+    status = validate_arg64(buf, len, key);
+    if (status != CIPHER_SUCCESS) {
+        return STATS_RESULT(status, 0U);
+    }
+
+    STATS_MARK();
+    cipher_shift_schedule(&sched, len, key);
+    run_tuned(buf, len, &sched, ctx->forward, ctx->span_lo, ctx->span_hi);
+    return STATS_RESULT(CIPHER_SUCCESS, len);
+}
+
+static cipher_status_t ctx_decrypt_buf64(const cipher_ctx_t *ctx, char *buf,
+                                        size_t len, uint64_t key)
+{
+    cipher_shift_schedule_t sched;
+    cipher_status_t status;
+
+    if (ctx == NULL) {
+        return STATS_RESULT(CIPHER_ERROR_NULL_POINTER, 0U);
+    }
+    status = validate_arg64(buf, len, key);
+    if (status != CIPHER_SUCCESS) {
+        return STATS_RESULT(status, 0U);
+    }
+
+    STATS_MARK();
+    cipher_shift_schedule(&sched, len, key);
+    cipher_shift_schedule_invert(&sched, len);
+    run_tuned(buf, len, &sched, ctx->inverse, ctx->span_lo, ctx->span_hi);
+    return STATS_RESULT(CIPHER_SUCCESS, len);
+}
+
+cipher_status_t cipher_ctx_encrypt_buf(const cipher_ctx_t *ctx, char *buf,
+                                       size_t len, int key)
+{
+    return ctx_encrypt_buf64(ctx, buf, len, widen_key(key));
+}
+
+cipher_status_t cipher_ctx_decrypt_buf(const cipher_ctx_t *ctx, char *buf,
+                                       size_t len, int key)
+{
+    return ctx_decrypt_buf64(ctx, buf, len, widen_key(key));
+}
+
+#if CIPHER_USE_DIRECT_MAPS || CIPHER_CONSTANT_TIME
+cipher_status_t cipher_encrypt_buf64(char *buf, size_t len, uint64_t key)
+{
+    return ctx_encrypt_buf64(&cipher_default_ctx, buf, len, key);
+}
+
+cipher_status_t cipher_decrypt_buf64(char *buf, size_t len, uint64_t key)
+{
+    return ctx_decrypt_buf64(&cipher_default_ctx, buf, len, key);
+}
+#else
+/*-------------------------------------------------------------
+ * Size profile: in-place path with a table search
+ *
+ * Searches the 40-byte pair table instead of indexing the direct
+ * maps, so an image that only uses the in-place entry points links
+ * neither the maps nor the tuned kernels (with --gc-sections).
+*-------------------------------------------------------------*/
+#define SEARCH_ROW(v, plain, enc) { (plain), (enc) },
+
+static const char search_table[CIPHER_TABLE_SIZE][2] = {
+    SUBSTITUTION_PAIRS(SEARCH_ROW, ~)
+};
+
+static void substitute_search(char *buf, size_t len, int decrypt)
+{
+    const int from = decrypt ? 1 : 0;
+    size_t i, t;
+
+    for (i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)buf[i];
+
+        if (c < ALPHABET_LO || c > ALPHABET_HI) {
+            continue;
+        }
+        for (t = 0; t < CIPHER_TABLE_SIZE; t++) {
+            if (search_table[t][from] == buf[i]) {
+                buf[i] = search_table[t][1 - from];
+                break;
+            }
+        }
+    }
+}
+
+static cipher_status_t search_buf64(char *buf, size_t len, uint64_t key,
+                                    int decrypt)
+{
+    cipher_shift_schedule_t sched;
+    cipher_status_t status = validate_arg64(buf, len, key);
+
+    if (status != CIPHER_SUCCESS) {
+        return STATS_RESULT(status, 0U);
+    }
+
+    STATS_MARK();
+    cipher_shift_schedule(&sched, len, key);
+    if (decrypt) {
+        substitute_search(buf, len, 1);             //Stage 1: Substitution
+        STATS_STAGE(subst_cycles);
+        cipher_shift_schedule_invert(&sched, len);
+        apply_shift(buf, len, &sched);              //Stage 2: Inverse Shift
+        STATS_STAGE(shift_cycles);
+    } else {
+        apply_shift(buf, len, &sched);              //Stage 1: Shift
+        STATS_STAGE(shift_cycles);
+        substitute_search(buf, len, 0);             //Stage 2: Substitution
+        STATS_STAGE(subst_cycles);
+    }
+    return STATS_RESULT(CIPHER_SUCCESS, len);
+}
+
+cipher_status_t cipher_encrypt_buf64(char *buf, size_t len, uint64_t key)
+{
+    return search_buf64(buf, len, key, 0);
+}
+
+cipher_status_t cipher_decrypt_buf64(char *buf, size_t len, uint64_t key)
+{
+    return search_buf64(buf, len, key, 1);
+}
+#endif
+
+cipher_status_t cipher_encrypt_buf(char *buf, size_t len, int key)
+{
+    return cipher_encrypt_buf64(buf, len, widen_key(key));
+}
+
+cipher_status_t cipher_decrypt_buf(char *buf, size_t len, int key)
+{
+    return cipher_decrypt_buf64(buf, len, widen_key(key));
+}
+
+cipher_status_t cipher_encrypt_buf_strict(char *buf, size_t len, int key,
+                                          size_t *bad_offset)
+{
+    return run_strict(&cipher_default_ctx, buf, len, key, bad_offset, 0);
+}
+
+cipher_status_t cipher_decrypt_buf_strict(char *buf, size_t len, int key,
+                                          size_t *bad_offset)
+{
+    return run_strict(&cipher_default_ctx, buf, len, key, bad_offset, 1);
+}
+
+cipher_status_t cipher_encrypt_uppercase_buf(char *buf, size_t len, int key)
+{
+    cipher_status_t status = validate_arg(buf, len, key);
+    if (status != CIPHER_SUCCESS) {
+        return STATS_RESULT(status, 0U);
+    }
+
+    STATS_MARK();
+    split_shift_left(buf, len, key);            //Stage 1: Shift
+    STATS_STAGE(shift_cycles);
+    substitute_span(buf, len, FOLD_FORWARD_MAP, //Stage 2: Uppercase + Substitution
+                    ALPHABET_LO, FOLD_HI);
+    STATS_STAGE(subst_cycles);
+    return STATS_RESULT(CIPHER_SUCCESS, len);
+}
+
+static cipher_status_t ctx_encrypt_to64(const cipher_ctx_t *ctx, const char *in,
+                                       char *out, size_t len, uint64_t key)
+{
+    cipher_shift_schedule_t sched;
+    cipher_status_t status;
+
+    if (ctx == NULL || out == NULL) {
+        return STATS_RESULT(CIPHER_ERROR_NULL_POINTER, 0U);
+    }
+    if (in == out) {
+        return ctx_encrypt_buf64(ctx, out, len, key);
+    }
+    status = validate_arg64(in, len, key);
+    if (status != CIPHER_SUCCESS) {
+        return STATS_RESULT(status, 0U);
+    }
+
+    STATS_MARK();
+    cipher_shift_schedule(&sched, len, key);
+    shift_substitute(in, out, len, &sched, ctx->forward,
+                     ctx->span_lo, ctx->span_hi);
+    STATS_STAGE(subst_cycles);
+    return STATS_RESULT(CIPHER_SUCCESS, len);
+}
+
+static cipher_status_t ctx_decrypt_to64(const cipher_ctx_t *ctx, const char *in,
+                                       char *out, size_t len, uint64_t key)
+{
+    cipher_shift_schedule_t sched;
+    cipher_status_t status;
+
+    if (ctx == NULL || out == NULL) {
+        return STATS_RESULT(CIPHER_ERROR_NULL_POINTER, 0U);
+    }
+    if (in == out) {
+        return ctx_decrypt_buf64(ctx, out, len, key);
+    }
+    status = validate_arg64(in, len, key);
+    if (status != CIPHER_SUCCESS) {
+        return STATS_RESULT(status, 0U);
+    }
+
+    STATS_MARK();
+    cipher_shift_schedule(&sched, len, key);
+    cipher_shift_schedule_invert(&sched, len);
+    shift_substitute(in, out, len, &sched, ctx->inverse,
+                     ctx->span_lo, ctx->span_hi);
+    STATS_STAGE(subst_cycles);
+    return STATS_RESULT(CIPHER_SUCCESS, len);
+}
+
+cipher_status_t cipher_ctx_encrypt_to(const cipher_ctx_t *ctx, const char *in,
+                                      char *out, size_t len, int key)
+{
+    return ctx_encrypt_to64(ctx, in, out, len, widen_key(key));
+}
+
+cipher_status_t cipher_ctx_decrypt_to(const cipher_ctx_t *ctx, const char *in,
+                                      char *out, size_t len, int key)
+{
+    return ctx_decrypt_to64(ctx, in, out, len, widen_key(key));
+}
+
+cipher_status_t cipher_encrypt_to(const char *in, char *out, size_t len, int key)
+{
+    return cipher_ctx_encrypt_to(&cipher_default_ctx, in, out, len, key);
+}
+
+cipher_status_t cipher_decrypt_to(const char *in, char *out, size_t len, int key)
+{
+    return cipher_ctx_decrypt_to(&cipher_default_ctx, in, out, len, key);
+}
+
+cipher_status_t cipher_encrypt_to64(const char *in, char *out, size_t len,
+                                    uint64_t key)
+{
+    return ctx_encrypt_to64(&cipher_default_ctx, in, out, len, key);
+}
+
+cipher_status_t cipher_decrypt_to64(const char *in, char *out, size_t len,
+                                    uint64_t key)
+{
+    return ctx_decrypt_to64(&cipher_default_ctx, in, out, len, key);
+}
+
+cipher_status_t cipher_encrypt_batch(cipher_span_t *frames, size_t count,
+                                     int key, cipher_status_t *status)
+{
+    return run_batch(frames, count, key, status, 0);
+}
+
+cipher_status_t cipher_decrypt_batch(cipher_span_t *frames, size_t count,
+                                     int key, cipher_status_t *status)
+{
+    return run_batch(frames, count, key, status, 1);
+}
+
+cipher_status_t cipher_encrypt_bulk(const char *in, const size_t *offsets,
+                                    size_t count, char *out, int key,
+                                    cipher_status_t *status)
+{
+    bulk_offsets_t bounds = { offsets, NULL };
+    return run_bulk(in, &bounds, count, out, key, status, 0);
+}
+
+cipher_status_t cipher_decrypt_bulk(const char *in, const size_t *offsets,
+                                    size_t count, char *out, int key,
+                                    cipher_status_t *status)
+{
+    bulk_offsets_t bounds = { offsets, NULL };
+    return run_bulk(in, &bounds, count, out, key, status, 1);
+}
+
+cipher_status_t cipher_encrypt_column(const char *data, const int32_t *offsets,
+                                      size_t count, char *out, int key,
+                                      cipher_status_t *status)
+{
+    bulk_offsets_t bounds = { NULL, offsets };
+    return run_bulk(data, &bounds, count, out, key, status, 0);
+}
+
+cipher_status_t cipher_decrypt_column(const char *data, const int32_t *offsets,
+                                      size_t count, char *out, int key,
+                                      cipher_status_t *status)
+{
+    bulk_offsets_t bounds = { NULL, offsets };
+    return run_bulk(data, &bounds, count, out, key, status, 1);
+}
+
+cipher_status_t cipher_encrypt_iov(const cipher_span_t *frags, size_t count,
+                                   int key)
+{
+    return run_iov(frags, count, key, 0);
+}
+
+cipher_status_t cipher_decrypt_iov(const cipher_span_t *frags, size_t count,
+                                   int key)
+{
+    return run_iov(frags, count, key, 1);
+}
+
+cipher_status_t cipher_key_init(cipher_key_t *handle, int key)
+{
+    size_t i;
+
+    if (handle == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (key <= 0) {
+        return CIPHER_ERROR_INVALID_KEY;
+    }
+
+    handle->key = key;
+    for (i = 0; i < CIPHER_KEY_SLOTS; i++) {
+        handle->slot[i].len = CIPHER_KEY_EMPTY;
+    }
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_key_prepare(cipher_key_t *handle, const size_t *lens,
+                                   size_t count)
+{
+    size_t i;
+
+    if (handle == NULL || lens == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    for (i = 0; i < count; i++) {
+        if (lens[i] > CIPHER_MAX_INPUT_LEN) {
+            return CIPHER_ERROR_INVALID_LENGTH;
+        }
+        key_learn(handle, lens[i]);
+    }
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_key_encrypt_buf(cipher_key_t *handle, char *buf,
+                                       size_t len)
+{
+    return run_key(handle, buf, len, 0);
+}
+
+cipher_status_t cipher_key_decrypt_buf(cipher_key_t *handle, char *buf,
+                                       size_t len)
+{
+    return run_key(handle, buf, len, 1);
+}
+
+cipher_status_t cipher_plan_init(cipher_plan_t *plan, cipher_index_t *storage,
+                                 size_t len, int key)
+{
+    cipher_shift_schedule_t sched;
+
+    if (plan == NULL || storage == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (key <= 0) {
+        return CIPHER_ERROR_INVALID_KEY;
+    }
+    if (len > CIPHER_MAX_INPUT_LEN) {
+        return CIPHER_ERROR_INVALID_LENGTH;
+    }
+
+    cipher_shift_schedule(&sched, len, key);
+    rotate_index(storage, 0U, sched.lower, sched.lower_rot);
+    rotate_index(storage + sched.lower, sched.lower, len - sched.lower,
+                 sched.upper_rot);
+
+    plan->index = storage;
+    plan->len   = len;
+    plan->key   = key;
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_plan_encrypt(const cipher_plan_t *plan,
+                                    const char *in, char *out)
+{
+    const cipher_index_t *index;
+    size_t j;
+
+    if (plan == NULL || in == NULL || out == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (in == out) {
+        return cipher_encrypt_buf(out, plan->len, plan->key);
+    }
+
+    index = plan->index;
+    for (j = 0; j < plan->len; j++) {           //Gather + Substitution
+        out[j] = (char)cipher_forward_map[(unsigned char)in[index[j]]];
+    }
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_plan_decrypt(const cipher_plan_t *plan,
+                                    const char *in, char *out)
+{
+    const cipher_index_t *index;
+    size_t j;
+
+    if (plan == NULL || in == NULL || out == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (in == out) {
+        return cipher_decrypt_buf(out, plan->len, plan->key);
+    }
+
+    index = plan->index;
+    for (j = 0; j < plan->len; j++) {           //Scatter + Reverse Substitution
+        out[index[j]] = (char)cipher_reverse_map[(unsigned char)in[j]];
+    }
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_ctx_init(cipher_ctx_t *ctx,
+                                const char table[CIPHER_TABLE_SIZE][2])
+{
+    unsigned char plain, enc;
+    size_t i;
+
+    if (ctx == NULL || table == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+
+    for (i = 0; i < 256U; i++) {
+        ctx->forward[i] = (unsigned char)i;
+        ctx->inverse[i] = (unsigned char)i;
+    }
+    ctx->span_lo = 0xFFU;
+    ctx->span_hi = 0x00U;
+
+    /* Identity entries mark symbols not yet seen in a column. */
+    for (i = 0; i < CIPHER_TABLE_SIZE; i++) {
+        plain = (unsigned char)table[i][0];
+        enc   = (unsigned char)table[i][1];
+        if (plain == enc || ctx->forward[plain] != plain ||
+            ctx->inverse[enc] != enc) {
+            return CIPHER_ERROR_INVALID_TABLE;
+        }
+        ctx->forward[plain] = enc;
+        ctx->inverse[enc]   = plain;
+        if (plain < ctx->span_lo) {
+            ctx->span_lo = plain;
+        }
+        if (plain > ctx->span_hi) {
+            ctx->span_hi = plain;
+        }
+    }
+
+    /* Same symbol set in both columns: every ciphertext symbol is also a
+     * plaintext symbol, which makes both maps permutations of all bytes. */
+    for (i = 0; i < CIPHER_TABLE_SIZE; i++) {
+        enc = (unsigned char)table[i][1];
+        if (ctx->forward[enc] == enc) {
+            return CIPHER_ERROR_INVALID_TABLE;
+        }
+    }
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_encrypt(char *str, int key)
+{
+    if (str == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    return cipher_encrypt_buf(str, bounded_strlen(str), key);
+}
+
+cipher_status_t cipher_decrypt(char *str, int key)
+{
+    if (str == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    return cipher_decrypt_buf(str, bounded_strlen(str), key);
+}
+
+cipher_status_t cipher_encrypt64(char *str, uint64_t key)
+{
+    if (str == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    return cipher_encrypt_buf64(str, bounded_strlen(str), key);
+}
+
+cipher_status_t cipher_decrypt64(char *str, uint64_t key)
+{
+    if (str == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    return cipher_decrypt_buf64(str, bounded_strlen(str), key);
+}
+
+cipher_status_t cipher_encrypt_uppercase(char *str, int key)
+{
+    if (str == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    return cipher_encrypt_uppercase_buf(str, bounded_strlen(str), key);
+}
+
+void cipher_stats_set_clock(cipher_cycle_fn clock)
+{
+#if CIPHER_ENABLE_STATS
+    stats_clock = clock;
+#else
+    (void)clock;
+#endif
+}
+
+void cipher_stats_snapshot(cipher_stats_t *snapshot)
+{
+    if (snapshot == NULL) {
+        return;
+    }
+#if CIPHER_ENABLE_STATS
+    *snapshot = stats;
+#else
+    memset(snapshot, 0, sizeof *snapshot);
+#endif
+}
+
+void cipher_stats_reset(void)
+{
+#if CIPHER_ENABLE_STATS
+    memset(&stats, 0, sizeof stats);
+#endif
+}
+
+cipher_status_t cipher_autotune(cipher_cycle_fn clock, char *scratch,
+                                size_t scratch_len, cipher_tune_t *table)
+{
+    static const char alphabet[] = "0123456789ABCDEF:,=;";
+    cipher_shift_schedule_t sched;
+    uint32_t cost, best_cost;
+    unsigned kernel, best;
+    size_t b, i, len;
+
+    if (clock == NULL || scratch == NULL || table == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (scratch_len == 0U) {
+        return CIPHER_ERROR_INVALID_LENGTH;
+    }
+    if (scratch_len > CIPHER_MAX_INPUT_LEN) {
+        scratch_len = CIPHER_MAX_INPUT_LEN;
+    }
+    for (i = 0; i < scratch_len; i++) {
+        scratch[i] = alphabet[(i * 7U) % 20U];
+    }
+
+    for (b = 0; b < CIPHER_TUNE_BUCKETS; b++) {
+        len = ((size_t)3U << b) / 2U;               /* middle of the bucket */
+        if (len > CIPHER_MAX_INPUT_LEN) {
+            len = CIPHER_MAX_INPUT_LEN;
+        }
+        if (len > scratch_len) {
+            table->kernel[b] = (b > 0U) ? table->kernel[b - 1U]
+                                        : (unsigned char)TUNE_DEFAULT;
+            continue;
+        }
+
+        cipher_shift_schedule(&sched, len, TUNE_KEY);
+        best      = TUNE_DEFAULT;
+        best_cost = UINT32_MAX;
+        for (kernel = 0; kernel < CIPHER_KERNEL_COUNT; kernel++) {
+            if (!tune_available(kernel) ||
+                (kernel == CIPHER_KERNEL_GATHER && len > TUNE_GATHER_MAX)) {
+                continue;
+            }
+            cost = tune_time(clock, kernel, scratch, len, &sched);
+            if (cost < best_cost) {
+                best      = kernel;
+                best_cost = cost;
+            }
+        }
+        table->kernel[b] = (unsigned char)best;
+    }
+
+    tune_active = table;
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_tune_use(const cipher_tune_t *table)
+{
+    size_t b;
+
+    if (table == NULL) {
+        tune_active = &tune_default;
+        return CIPHER_SUCCESS;
+    }
+    for (b = 0; b < CIPHER_TUNE_BUCKETS; b++) {
+        if (!tune_available(table->kernel[b])) {
+            return CIPHER_ERROR_INVALID_TABLE;
+        }
+    }
+    tune_active = table;
     return CIPHER_SUCCESS;
 }
 
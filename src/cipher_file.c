@@ -0,0 +1,300 @@
+/**
+ * @file cipher_file.c
+ * @brief Record-wise encrypt/decrypt of memory-mapped archives (host only).
+ *
+ * See cipher_file.h for the record layouts. Not part of libcipher.a.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "cipher_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NO_FAILURE ((size_t)-1)
+#define LEN16_PREFIX 2U
+
+/* Pass state shared by the record scanners */
+typedef struct {
+    const char              *in;
+    char                    *out;
+    int                      key;
+    int                      decrypt;
+    cipher_status_t          result;     /* error of the first failure */
+    cipher_records_report_t *report;
+} record_pass_t;
+
+static void record_failed(record_pass_t *pass, size_t pos,
+                          cipher_status_t status)
+{
+    if (pass->report->failed++ == 0U) {
+        pass->report->first_failed = pos;
+        pass->result = status;
+    }
+}
+
+/* Copy in[pos .. pos+len-1] through unchanged (no-op in place) */
+static void copy_through(record_pass_t *pass, size_t pos, size_t len)
+{
+    if (pass->in != pass->out) {
+        memcpy(pass->out + pos, pass->in + pos, len);
+    }
+}
+
+/*-------------------------------------------------------------
+ * One record: `len` bytes at in[pos] -> out[pos]. A record the
+ * cipher rejects is copied through unchanged.
+*-------------------------------------------------------------*/
+static void run_record(record_pass_t *pass, size_t pos, size_t len)
+{
+    cipher_status_t status;
+
+    status = pass->decrypt
+        ? cipher_decrypt_to(pass->in + pos, pass->out + pos, len, pass->key)
+        : cipher_encrypt_to(pass->in + pos, pass->out + pos, len, pass->key);
+    pass->report->records++;
+    if (status != CIPHER_SUCCESS) {
+        copy_through(pass, pos, len);
+        record_failed(pass, pos, status);
+    }
+}
+
+/*-------------------------------------------------------------
+ * Newline-delimited records
+*-------------------------------------------------------------*/
+static void scan_newline(record_pass_t *pass, size_t size)
+{
+    const char *nl;
+    size_t pos = 0U, len;
+
+    while (pos < size) {
+        nl  = memchr(pass->in + pos, '\n', size - pos);
+        len = (nl != NULL) ? (size_t)(nl - (pass->in + pos)) : size - pos;
+        run_record(pass, pos, len);
+        pos += len;
+        if (nl != NULL) {
+            copy_through(pass, pos, 1U);
+            pos++;
+        }
+    }
+}
+
+/*-------------------------------------------------------------
+ * Length-prefixed records. A prefix or record cut short by the
+ * end of the data is one failed record, kept as it is.
+*-------------------------------------------------------------*/
+static void scan_len16(record_pass_t *pass, size_t size)
+{
+    const unsigned char *prefix;
+    size_t pos = 0U, len;
+
+    while (size - pos >= LEN16_PREFIX) {
+        prefix = (const unsigned char *)pass->in + pos;
+        len    = (size_t)prefix[0] | ((size_t)prefix[1] << 8);
+        copy_through(pass, pos, LEN16_PREFIX);
+        pos += LEN16_PREFIX;
+        if (len > size - pos) {
+            break;
+        }
+        run_record(pass, pos, len);
+        pos += len;
+    }
+    if (pos < size) {
+        pass->report->records++;
+        copy_through(pass, pos, size - pos);
+        record_failed(pass, pos, CIPHER_ERROR_INVALID_LENGTH);
+    }
+}
+
+/*-------------------------------------------------------------
+ * Record pass shared by cipher_records_encrypt() / _decrypt()
+*-------------------------------------------------------------*/
+static cipher_status_t run_records(const char *in, char *out, size_t size,
+                                   int key, cipher_record_format_t format,
+                                   cipher_records_report_t *report,
+                                   int decrypt)
+{
+    cipher_records_report_t local;
+    record_pass_t pass;
+
+    if (in == NULL || out == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (key <= 0) {
+        return CIPHER_ERROR_INVALID_KEY;
+    }
+
+    pass.in      = in;
+    pass.out     = out;
+    pass.key     = key;
+    pass.decrypt = decrypt;
+    pass.result  = CIPHER_SUCCESS;
+    pass.report  = (report != NULL) ? report : &local;
+    pass.report->records      = 0U;
+    pass.report->failed       = 0U;
+    pass.report->first_failed = NO_FAILURE;
+
+    if (format == CIPHER_RECORDS_LEN16) {
+        scan_len16(&pass, size);
+    } else {
+        scan_newline(&pass, size);
+    }
+    return pass.result;
+}
+
+/*-------------------------------------------------------------
+ * Map `size` bytes of `fd` and advise sequential access
+*-------------------------------------------------------------*/
+static void *map_file(int fd, size_t size, int prot)
+{
+    void *map = mmap(NULL, size, prot, MAP_SHARED, fd, 0);
+
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    (void)posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+    return map;
+}
+
+/* Size of an open file, or -1 (errno set) if it cannot be mapped whole */
+static int file_size(int fd, size_t *size)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) != 0) {
+        return -1;
+    }
+    if (st.st_size < 0 || (uintmax_t)st.st_size > (uintmax_t)SIZE_MAX) {
+        errno = EFBIG;
+        return -1;
+    }
+    *size = (size_t)st.st_size;
+    return 0;
+}
+
+/* 1 if both descriptors are the same file, 0 if not, -1 (errno set) */
+static int same_file(int a, int b)
+{
+    struct stat sa, sb;
+
+    if (fstat(a, &sa) != 0 || fstat(b, &sb) != 0) {
+        return -1;
+    }
+    return sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+/*-------------------------------------------------------------
+ * File driver shared by cipher_file_encrypt() / _decrypt()
+*-------------------------------------------------------------*/
+static cipher_status_t run_file(const char *in_path, const char *out_path,
+                                int key, cipher_record_format_t format,
+                                cipher_records_report_t *report, int decrypt)
+{
+    cipher_status_t status = CIPHER_ERROR_IO;
+    int in_place = (out_path == NULL);
+    char empty = '\0';
+    int in_fd, out_fd = -1, saved_errno;
+    char *in_map = NULL, *out_map = NULL;
+    size_t size = 0U;
+
+    if (in_path == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (key <= 0) {
+        return CIPHER_ERROR_INVALID_KEY;
+    }
+
+    in_fd = open(in_path, in_place ? O_RDWR : O_RDONLY);
+    if (in_fd < 0 || file_size(in_fd, &size) != 0) {
+        goto done;
+    }
+    if (!in_place) {
+        /* no O_TRUNC yet: out_path may name in_path (or a link to it) */
+        out_fd = open(out_path, O_RDWR | O_CREAT, 0644);
+        if (out_fd < 0) {
+            goto done;
+        }
+        in_place = same_file(in_fd, out_fd);
+        if (in_place < 0) {
+            goto done;
+        }
+        if (in_place) {                         /* rewrite through out_fd */
+            (void)close(in_fd);
+            in_fd = out_fd;
+            out_fd = -1;
+        } else if (ftruncate(out_fd, 0) != 0 ||
+                   ftruncate(out_fd, (off_t)size) != 0) {
+            goto done;
+        }
+    }
+
+    if (size == 0U) {                           /* nothing to map */
+        status = run_records(&empty, &empty, 0U, key, format, report, decrypt);
+        goto done;
+    }
+    in_map = map_file(in_fd, size, in_place ? PROT_READ | PROT_WRITE : PROT_READ);
+    if (in_map == NULL) {
+        goto done;
+    }
+    out_map = in_place ? in_map : map_file(out_fd, size, PROT_READ | PROT_WRITE);
+    if (out_map == NULL) {
+        goto done;
+    }
+
+    status = run_records(in_map, out_map, size, key, format, report, decrypt);
+
+done:
+    saved_errno = errno;
+    if (out_map != NULL && out_map != in_map) {
+        (void)munmap(out_map, size);
+    }
+    if (in_map != NULL) {
+        (void)munmap(in_map, size);
+    }
+    if (out_fd >= 0) {
+        (void)close(out_fd);
+    }
+    if (in_fd >= 0) {
+        (void)close(in_fd);
+    }
+    errno = saved_errno;
+    return status;
+}
+
+/*-------------------------------------------------------------
+ * Public
+*-------------------------------------------------------------*/
+cipher_status_t cipher_records_encrypt(const char *in, char *out, size_t size,
+                                       int key, cipher_record_format_t format,
+                                       cipher_records_report_t *report)
+{
+    return run_records(in, out, size, key, format, report, 0);
+}
+
+cipher_status_t cipher_records_decrypt(const char *in, char *out, size_t size,
+                                       int key, cipher_record_format_t format,
+                                       cipher_records_report_t *report)
+{
+    return run_records(in, out, size, key, format, report, 1);
+}
+
+cipher_status_t cipher_file_encrypt(const char *in_path, const char *out_path,
+                                    int key, cipher_record_format_t format,
+                                    cipher_records_report_t *report)
+{
+    return run_file(in_path, out_path, key, format, report, 0);
+}
+
+cipher_status_t cipher_file_decrypt(const char *in_path, const char *out_path,
+                                    int key, cipher_record_format_t format,
+                                    cipher_records_report_t *report)
+{
+    return run_file(in_path, out_path, key, format, report, 1);
+}
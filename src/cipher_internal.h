@@ -0,0 +1,60 @@
+/**
+ * @file cipher_internal.h
+ * @brief Declarations shared between the library's translation units.
+ *
+ * Not part of the public API; nothing outside src/ should include this.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#ifndef CIPHER_INTERNAL_H
+#define CIPHER_INTERNAL_H
+
+#include "cipher.h"
+
+/** Built-in direct maps (plaintext -> ciphertext and back), in cipher.c. */
+#define cipher_forward_map (cipher_default_ctx.forward)
+#define cipher_reverse_map (cipher_default_ctx.inverse)
+
+/**
+ * Shift schedule: left-rotation amounts of both halves of a `len`-byte
+ * buffer, reduced from the key once so the kernels never see the key.
+ */
+typedef struct {
+    size_t lower;           /* length of the lower half (includes mid) */
+    size_t lower_rot;       /* left rotation of [0 .. lower-1]         */
+    size_t upper_rot;       /* left rotation of [lower .. len-1]       */
+} cipher_shift_schedule_t;
+
+/**
+ * Encryption schedule for `len` bytes under `key` (> 0). Takes the 64-bit
+ * key of the *64 entry points; an int key converts to the same schedule.
+ */
+void cipher_shift_schedule(cipher_shift_schedule_t *sched, size_t len,
+                           uint64_t key);
+
+/** Turn an encryption schedule for `len` bytes into the decryption one. */
+void cipher_shift_schedule_invert(cipher_shift_schedule_t *sched, size_t len);
+
+#if CIPHER_ENABLE_STATS
+/** Add plan cache events to the calling thread's stats (cipher_plan_cache.c). */
+void cipher_stats_plan_cache(uint32_t hits, uint32_t misses, uint32_t evictions);
+#endif
+
+#if CIPHER_USE_SIMD
+/**
+ * Substitute buf[0 .. len-1] through a 256-entry direct map using the
+ * widest vector kernel the running CPU supports (scalar otherwise). The
+ * map must be the identity outside [lo, hi]; only the 16-byte rows that
+ * span covers are applied.
+ *
+ * Returns the offset of the first byte the map leaves unchanged, i.e. the
+ * first byte outside the alphabet, or `len` if there is none. With `stop`
+ * set the kernel returns at that byte: bytes before it are substituted,
+ * it and everything after it are left unchanged.
+ */
+size_t cipher_simd_substitute(unsigned char *buf, size_t len,
+                              const unsigned char map[256], unsigned lo,
+                              unsigned hi, int stop);
+#endif
+
+#endif
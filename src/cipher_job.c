@@ -0,0 +1,157 @@
+/**
+ * @file cipher_job.c
+ * @brief Resumable in-place encryption with bounded work per call.
+ *
+ * See cipher_job.h for usage notes.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#include "cipher_job.h"
+#include "cipher_internal.h"
+
+/*-------------------------------------------------------------
+ * Phases
+ *
+ * The shift is the three reversals of rotate_left() on each
+ * half, run one after the other, followed by the substitution:
+ *
+ *   0..2  lower half: [0, k)    [k, L)    [0, L)
+ *   3..5  upper half: [L, L+k)  [L+k, n)  [L, n)
+ *   6     substitution of [0, n)
+ *
+ * A half whose rotation is 0 skips its three reversals.
+*-------------------------------------------------------------*/
+enum {
+    JOB_LOWER = 0U,
+    JOB_UPPER = 3U,
+    JOB_SUBST = 6U,
+    JOB_DONE  = 7U
+};
+
+/* Enter `phase`, or the first later one that has work */
+static void job_enter(cipher_job_t *job, unsigned phase)
+{
+    size_t base, n, k;
+
+    if (phase < JOB_UPPER && job->lower_rot == 0U) {
+        phase = JOB_UPPER;
+    }
+    if (phase >= JOB_UPPER && phase < JOB_SUBST && job->upper_rot == 0U) {
+        phase = JOB_SUBST;
+    }
+    job->phase = phase;
+
+    if (phase >= JOB_SUBST) {
+        job->lo = 0U;
+        job->hi = job->len;
+        return;
+    }
+    if (phase < JOB_UPPER) {
+        base = 0U;
+        n    = job->lower;
+        k    = job->lower_rot;
+    } else {
+        base = job->lower;
+        n    = job->len - job->lower;
+        k    = job->upper_rot;
+    }
+    switch (phase % 3U) {
+    case 0U:                                    /* [0, k) */
+        job->lo = base;
+        job->hi = base + k;
+        break;
+    case 1U:                                    /* [k, n) */
+        job->lo = base + k;
+        job->hi = base + n;
+        break;
+    default:                                    /* [0, n) */
+        job->lo = base;
+        job->hi = base + n;
+        break;
+    }
+}
+
+/*-------------------------------------------------------------
+ * Common init
+*-------------------------------------------------------------*/
+static cipher_status_t job_init(cipher_job_t *job, char *buf, size_t len,
+                                int key, int decrypt)
+{
+    cipher_shift_schedule_t sched;
+
+    if (job == NULL || buf == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (key <= 0) {
+        return CIPHER_ERROR_INVALID_KEY;
+    }
+    if (len > CIPHER_MAX_INPUT_LEN) {
+        return CIPHER_ERROR_INVALID_LENGTH;
+    }
+
+    cipher_shift_schedule(&sched, len, key);
+    if (decrypt) {
+        cipher_shift_schedule_invert(&sched, len);
+    }
+
+    job->buf       = buf;
+    job->len       = len;
+    job->lower     = sched.lower;
+    job->lower_rot = sched.lower_rot;
+    job->upper_rot = sched.upper_rot;
+    job->map       = decrypt ? cipher_reverse_map : cipher_forward_map;
+    job_enter(job, JOB_LOWER);
+    return CIPHER_SUCCESS;
+}
+
+/*-------------------------------------------------------------
+ * Public
+*-------------------------------------------------------------*/
+cipher_status_t cipher_job_encrypt_init(cipher_job_t *job, char *buf,
+                                        size_t len, int key)
+{
+    return job_init(job, buf, len, key, 0);
+}
+
+cipher_status_t cipher_job_decrypt_init(cipher_job_t *job, char *buf,
+                                        size_t len, int key)
+{
+    return job_init(job, buf, len, key, 1);
+}
+
+cipher_status_t cipher_job_step(cipher_job_t *job, size_t budget)
+{
+    char *buf;
+    char temp;
+
+    if (job == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+
+    buf = job->buf;
+    while (job->phase != JOB_DONE && budget > 0U) {
+        if (job->phase == JOB_SUBST) {                  //Stage 2: Substitution
+            while (job->lo < job->hi && budget > 0U) {
+                buf[job->lo] = (char)job->map[(unsigned char)buf[job->lo]];
+                job->lo++;
+                budget--;
+            }
+            if (job->lo == job->hi) {
+                job->phase = JOB_DONE;
+            }
+        } else {                                        //Stage 1: Shift
+            while (job->lo + 1U < job->hi && budget > 0U) {
+                job->hi--;
+                temp = buf[job->lo];
+                buf[job->lo] = buf[job->hi];
+                buf[job->hi] = temp;
+                job->lo++;
+                budget--;
+            }
+            if (job->lo + 1U >= job->hi) {
+                job_enter(job, job->phase + 1U);
+            }
+        }
+    }
+    return (job->phase == JOB_DONE) ? CIPHER_SUCCESS : CIPHER_IN_PROGRESS;
+}
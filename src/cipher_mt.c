@@ -0,0 +1,430 @@
+/**
+ * @file cipher_mt.c
+ * @brief Work-stealing worker pool over the batch API (host only).
+ *
+ * See cipher_mt.h for usage notes. Not part of libcipher.a.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "cipher_mt.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NO_FAILURE ((size_t)-1)
+
+/*-------------------------------------------------------------
+ * Per-worker queue: the frame range [head, tail) still to do.
+ * The owner takes from the head, thieves from the tail.
+*-------------------------------------------------------------*/
+typedef struct {
+    pthread_mutex_t lock;
+    size_t          head;
+    size_t          tail;
+    size_t          first_bad;      /* lowest failing index seen */
+    cipher_status_t bad_status;
+} worker_queue_t;
+
+typedef struct {
+    cipher_mt_pool_t *pool;
+    unsigned          id;
+} worker_arg_t;
+
+/*-------------------------------------------------------------
+ * Per-worker plan cache (cipher_mt_pool_plan_cache()). Only its
+ * worker ever touches it, so the hot path takes no lock. Plans
+ * only gather/scatter out of place (in == out would skip the plan
+ * and run the in-place kernel), so each frame goes through the
+ * worker's scratch and is copied back.
+*-------------------------------------------------------------*/
+typedef struct {
+    cipher_plan_cache_t cache;
+    cipher_index_t     *arena;
+    char               *scratch;    /* CIPHER_MAX_INPUT_LEN bytes */
+} worker_cache_t;
+
+struct cipher_mt_pool {
+    unsigned         nworkers;      /* including the calling thread */
+    unsigned         nstarted;      /* helper threads actually running */
+    pthread_t       *threads;       /* nworkers - 1 helpers, from index 1 */
+    worker_arg_t    *args;
+    worker_queue_t  *queues;
+    worker_cache_t  *caches;        /* NULL unless plan caching is on */
+
+    pthread_mutex_t  lock;
+    pthread_cond_t   wake;
+    pthread_cond_t   done;
+    unsigned long    generation;
+    unsigned         active;
+    int              shutdown;
+
+    /* current batch */
+    cipher_span_t   *frames;
+    cipher_status_t *status;
+    int              key;
+    int              decrypt;
+};
+
+/*-------------------------------------------------------------
+ * Take the next slice of the worker's own queue
+*-------------------------------------------------------------*/
+static int take_own(worker_queue_t *q, size_t *begin, size_t *end)
+{
+    int got = 0;
+
+    pthread_mutex_lock(&q->lock);
+    if (q->head < q->tail) {
+        *begin  = q->head;
+        *end    = (q->tail - q->head > CIPHER_MT_GRAIN) ? q->head + CIPHER_MT_GRAIN
+                                                        : q->tail;
+        q->head = *end;
+        got     = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return got;
+}
+
+/*-------------------------------------------------------------
+ * Move the back half of some other worker's queue into our own
+*-------------------------------------------------------------*/
+static int steal(cipher_mt_pool_t *pool, unsigned id)
+{
+    worker_queue_t *own = &pool->queues[id];
+    worker_queue_t *victim;
+    size_t begin = 0, end = 0;
+    unsigned k;
+
+    for (k = 1; k < pool->nworkers && begin == end; k++) {
+        victim = &pool->queues[(id + k) % pool->nworkers];
+        pthread_mutex_lock(&victim->lock);
+        if (victim->head < victim->tail) {
+            end          = victim->tail;
+            begin        = end - (victim->tail - victim->head + 1U) / 2U;
+            victim->tail = begin;
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+    if (begin == end) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&own->lock);
+    own->head = begin;
+    own->tail = end;
+    pthread_mutex_unlock(&own->lock);
+    return 1;
+}
+
+/*-------------------------------------------------------------
+ * Process frames [begin, end) through the single-threaded batch
+ * API (or the worker's plan cache), recording the lowest failing
+ * index for this worker.
+*-------------------------------------------------------------*/
+/* One frame through the worker's plan into scratch, then back */
+static cipher_status_t process_cached(worker_cache_t *wc, cipher_span_t *frame,
+                                      int key, int decrypt)
+{
+    cipher_status_t status;
+
+    if (frame->data == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    status = decrypt
+           ? cipher_plan_cache_decrypt(&wc->cache, frame->data, wc->scratch,
+                                       frame->len, key)
+           : cipher_plan_cache_encrypt(&wc->cache, frame->data, wc->scratch,
+                                       frame->len, key);
+    if (status == CIPHER_SUCCESS) {
+        memcpy(frame->data, wc->scratch, frame->len);
+    }
+    return status;
+}
+
+static void process(cipher_mt_pool_t *pool, unsigned id,
+                    size_t begin, size_t end)
+{
+    worker_queue_t *q = &pool->queues[id];
+    cipher_status_t local[CIPHER_MT_GRAIN];
+    cipher_status_t *st;
+    size_t n, i;
+
+    while (begin < end) {
+        n  = (end - begin > CIPHER_MT_GRAIN) ? CIPHER_MT_GRAIN : end - begin;
+        st = (pool->status != NULL) ? pool->status + begin : local;
+
+        if (pool->caches != NULL) {
+            for (i = 0; i < n; i++) {
+                st[i] = process_cached(&pool->caches[id], &pool->frames[begin + i],
+                                       pool->key, pool->decrypt);
+            }
+        } else if (pool->decrypt) {
+            cipher_decrypt_batch(pool->frames + begin, n, pool->key, st);
+        } else {
+            cipher_encrypt_batch(pool->frames + begin, n, pool->key, st);
+        }
+        for (i = 0; i < n; i++) {
+            if (st[i] != CIPHER_SUCCESS && begin + i < q->first_bad) {
+                q->first_bad  = begin + i;
+                q->bad_status = st[i];
+                break;
+            }
+        }
+        begin += n;
+    }
+}
+
+static void run_worker(cipher_mt_pool_t *pool, unsigned id)
+{
+    worker_queue_t *q = &pool->queues[id];
+    size_t begin, end;
+
+    for (;;) {
+        if (take_own(q, &begin, &end)) {
+            process(pool, id, begin, end);
+        } else if (!steal(pool, id)) {
+            break;
+        }
+    }
+}
+
+/*-------------------------------------------------------------
+ * Helper thread: sleep until a new batch generation, work it,
+ * report completion.
+*-------------------------------------------------------------*/
+static void *helper_main(void *arg)
+{
+    worker_arg_t *wa = (worker_arg_t *)arg;
+    cipher_mt_pool_t *pool = wa->pool;
+    unsigned long seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        run_worker(pool, wa->id);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0U) {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+static cipher_status_t run_batch_mt(cipher_mt_pool_t *pool,
+                                    cipher_span_t *frames, size_t count,
+                                    int key, cipher_status_t *status,
+                                    int decrypt)
+{
+    size_t first_bad = NO_FAILURE;
+    cipher_status_t result = CIPHER_SUCCESS;
+    unsigned i;
+
+    if (pool == NULL || frames == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+
+    /* Even split by frame count; stealing evens out the bytes. */
+    for (i = 0; i < pool->nworkers; i++) {
+        worker_queue_t *q = &pool->queues[i];
+        q->head       = count * i / pool->nworkers;
+        q->tail       = count * (i + 1U) / pool->nworkers;
+        q->first_bad  = NO_FAILURE;
+        q->bad_status = CIPHER_SUCCESS;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->frames  = frames;
+    pool->status  = status;
+    pool->key     = key;
+    pool->decrypt = decrypt;
+    pool->active  = pool->nworkers - 1U;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_worker(pool, 0U);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active != 0U) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->nworkers; i++) {
+        if (pool->queues[i].first_bad < first_bad) {
+            first_bad = pool->queues[i].first_bad;
+            result    = pool->queues[i].bad_status;
+        }
+    }
+    return result;
+}
+
+static void free_caches(cipher_mt_pool_t *pool)
+{
+    unsigned i;
+
+    if (pool->caches == NULL) {
+        return;
+    }
+    for (i = 0; i < pool->nworkers; i++) {
+        free(pool->caches[i].arena);
+        free(pool->caches[i].scratch);
+    }
+    free(pool->caches);
+    pool->caches = NULL;
+}
+
+/*-------------------------------------------------------------
+ * Public
+*-------------------------------------------------------------*/
+cipher_mt_pool_t *cipher_mt_pool_create(unsigned threads)
+{
+    cipher_mt_pool_t *pool;
+    unsigned i;
+
+    if (threads == 0U) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (online > 0) ? (unsigned)online : 1U;
+    }
+
+    pool = (cipher_mt_pool_t *)calloc(1, sizeof(*pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->nworkers = threads;
+    pool->queues   = (worker_queue_t *)calloc(threads, sizeof(worker_queue_t));
+    pool->threads  = (pthread_t *)calloc(threads, sizeof(pthread_t));
+    pool->args     = (worker_arg_t *)calloc(threads, sizeof(worker_arg_t));
+    if (pool->queues == NULL || pool->threads == NULL || pool->args == NULL) {
+        free(pool->queues);
+        free(pool->threads);
+        free(pool->args);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (i = 0; i < threads; i++) {
+        pthread_mutex_init(&pool->queues[i].lock, NULL);
+    }
+
+    for (i = 1; i < threads; i++) {
+        pool->args[i].pool = pool;
+        pool->args[i].id   = i;
+        if (pthread_create(&pool->threads[i], NULL, helper_main,
+                           &pool->args[i]) != 0) {
+            cipher_mt_pool_destroy(pool);
+            return NULL;
+        }
+        pool->nstarted++;
+    }
+    return pool;
+}
+
+void cipher_mt_pool_destroy(cipher_mt_pool_t *pool)
+{
+    unsigned i;
+
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 1; i <= pool->nstarted; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (i = 0; i < pool->nworkers; i++) {
+        pthread_mutex_destroy(&pool->queues[i].lock);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    free_caches(pool);
+    free(pool->queues);
+    free(pool->threads);
+    free(pool->args);
+    free(pool);
+}
+
+cipher_status_t cipher_mt_decrypt_batch(cipher_mt_pool_t *pool,
+                                        cipher_span_t *frames, size_t count,
+                                        int key, cipher_status_t *status)
+{
+    return run_batch_mt(pool, frames, count, key, status, 1);
+}
+
+cipher_status_t cipher_mt_encrypt_batch(cipher_mt_pool_t *pool,
+                                        cipher_span_t *frames, size_t count,
+                                        int key, cipher_status_t *status)
+{
+    return run_batch_mt(pool, frames, count, key, status, 0);
+}
+
+cipher_status_t cipher_mt_pool_plan_cache(cipher_mt_pool_t *pool, size_t arena_len)
+{
+    worker_cache_t *caches;
+    unsigned i;
+
+    if (pool == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    free_caches(pool);
+    if (arena_len == 0U) {
+        return CIPHER_SUCCESS;
+    }
+
+    caches = (worker_cache_t *)calloc(pool->nworkers, sizeof(worker_cache_t));
+    if (caches == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    pool->caches = caches;
+    for (i = 0; i < pool->nworkers; i++) {
+        caches[i].arena   = (cipher_index_t *)malloc(arena_len * sizeof(cipher_index_t));
+        caches[i].scratch = (char *)malloc(CIPHER_MAX_INPUT_LEN);
+        if (caches[i].arena == NULL || caches[i].scratch == NULL) {
+            free_caches(pool);
+            return CIPHER_ERROR_NULL_POINTER;
+        }
+        cipher_plan_cache_init(&caches[i].cache, caches[i].arena, arena_len);
+    }
+    return CIPHER_SUCCESS;
+}
+
+void cipher_mt_pool_plan_stats(const cipher_mt_pool_t *pool,
+                               cipher_plan_cache_stats_t *snapshot)
+{
+    unsigned i;
+
+    if (snapshot == NULL) {
+        return;
+    }
+    memset(snapshot, 0, sizeof *snapshot);
+    if (pool == NULL || pool->caches == NULL) {
+        return;
+    }
+    for (i = 0; i < pool->nworkers; i++) {
+        snapshot->hits      += pool->caches[i].cache.stats.hits;
+        snapshot->misses    += pool->caches[i].cache.stats.misses;
+        snapshot->evictions += pool->caches[i].cache.stats.evictions;
+    }
+}
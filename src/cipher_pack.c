@@ -0,0 +1,302 @@
+/**
+ * @file cipher_pack.c
+ * @brief Packed wire format (base-20, 13 bits per 3 symbols).
+ *
+ * See cipher_pack.h for the format.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#include "cipher_pack.h"
+#include "cipher_internal.h"
+
+/* Symbol of each code: the alphabet in byte order. */
+static const char CODE_SYMBOL[CIPHER_TABLE_SIZE + 1U] = ",0123456789:;=ABCDEF";
+
+/* Code + 1 of each symbol; 0 for bytes outside the alphabet. */
+static const unsigned char SYMBOL_CODE[256] = {
+    [','] = 1,  ['0'] = 2,  ['1'] = 3,  ['2'] = 4,  ['3'] = 5,
+    ['4'] = 6,  ['5'] = 7,  ['6'] = 8,  ['7'] = 9,  ['8'] = 10,
+    ['9'] = 11, [':'] = 12, [';'] = 13, ['='] = 14, ['A'] = 15,
+    ['B'] = 16, ['C'] = 17, ['D'] = 18, ['E'] = 19, ['F'] = 20
+};
+
+/*-------------------------------------------------------------
+ * Group geometry: a group of n codes (1..3) takes 4n + 1 bits,
+ * except that a full group fits 13 bits (20^3 = 8000 < 2^13).
+*-------------------------------------------------------------*/
+#define GROUP_CODES 3U
+#define GROUP_BITS  13U
+
+static unsigned group_bits(unsigned n)
+{
+    return (n == GROUP_CODES) ? GROUP_BITS : 4U * n + 1U;
+}
+
+/*-------------------------------------------------------------
+ * Bit writer
+*-------------------------------------------------------------*/
+typedef struct {
+    unsigned char *out;
+    uint32_t       acc;     /* pending bits, LSB first      */
+    unsigned       nbits;   /* number of pending bits (< 8) */
+    unsigned       group;   /* base-20 value of open group  */
+    unsigned       ncodes;  /* codes in the open group      */
+    unsigned       scale;   /* weight of the next code      */
+} pack_writer_t;
+
+static void put_bits(pack_writer_t *w, unsigned value, unsigned n)
+{
+    w->acc |= (uint32_t)value << w->nbits;
+    w->nbits += n;
+    while (w->nbits >= 8U) {
+        *w->out++ = (unsigned char)w->acc;
+        w->acc >>= 8;
+        w->nbits -= 8U;
+    }
+}
+
+static void put_code(pack_writer_t *w, unsigned code)
+{
+    w->group += code * w->scale;
+    w->scale *= CIPHER_TABLE_SIZE;
+    if (++w->ncodes == GROUP_CODES) {
+        put_bits(w, w->group, GROUP_BITS);
+        w->group  = 0U;
+        w->ncodes = 0U;
+        w->scale  = 1U;
+    }
+}
+
+static void writer_init(pack_writer_t *w, unsigned char *out)
+{
+    w->out    = out;
+    w->acc    = 0U;
+    w->nbits  = 0U;
+    w->group  = 0U;
+    w->ncodes = 0U;
+    w->scale  = 1U;
+}
+
+static void writer_finish(pack_writer_t *w)
+{
+    if (w->ncodes > 0U) {
+        put_bits(w, w->group, group_bits(w->ncodes));
+    }
+    if (w->nbits > 0U) {
+        *w->out++ = (unsigned char)w->acc;
+    }
+}
+
+/* Pack map[in[0 .. n-1]]; 0 on success, -1 on a byte outside the alphabet. */
+static int pack_run(pack_writer_t *w, const char *in, size_t n,
+                    const unsigned char map[256])
+{
+    unsigned code;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        code = SYMBOL_CODE[map[(unsigned char)in[i]]];
+        if (code == 0U) {
+            return -1;
+        }
+        put_code(w, code - 1U);
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------
+ * Bit reader
+*-------------------------------------------------------------*/
+typedef struct {
+    const unsigned char *in;
+    uint32_t             acc;
+    unsigned             nbits;
+    unsigned             group;     /* undecoded codes of the group */
+    unsigned             ncodes;    /* codes left in the group      */
+    size_t               remaining; /* codes left in the stream     */
+} pack_reader_t;
+
+static unsigned get_bits(pack_reader_t *r, unsigned n)
+{
+    unsigned value;
+
+    while (r->nbits < n) {
+        r->acc |= (uint32_t)*r->in++ << r->nbits;
+        r->nbits += 8U;
+    }
+    value = (unsigned)(r->acc & ((1UL << n) - 1U));
+    r->acc >>= n;
+    r->nbits -= n;
+    return value;
+}
+
+/* Next code, or -1 if the group holds a value no symbols produce. */
+static int get_code(pack_reader_t *r)
+{
+    unsigned n, limit, code;
+
+    if (r->ncodes == 0U) {
+        n = (r->remaining < GROUP_CODES) ? (unsigned)r->remaining : GROUP_CODES;
+        limit = (n == 3U) ? 8000U : (n == 2U) ? 400U : 20U;
+        r->group  = get_bits(r, group_bits(n));
+        r->ncodes = n;
+        if (r->group >= limit) {
+            return -1;
+        }
+    }
+    code = r->group % CIPHER_TABLE_SIZE;
+    r->group /= CIPHER_TABLE_SIZE;
+    r->ncodes--;
+    r->remaining--;
+    return (int)code;
+}
+
+static void reader_init(pack_reader_t *r, const unsigned char *in, size_t len)
+{
+    r->in        = in;
+    r->acc       = 0U;
+    r->nbits     = 0U;
+    r->group     = 0U;
+    r->ncodes    = 0U;
+    r->remaining = len;
+}
+
+/* Unpack n symbols into out[] through map; 0 on success, -1 on bad data. */
+static int unpack_run(pack_reader_t *r, char *out, size_t n,
+                      const unsigned char map[256])
+{
+    int code;
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        code = get_code(r);
+        if (code < 0) {
+            return -1;
+        }
+        out[i] = (char)map[(unsigned char)CODE_SYMBOL[code]];
+    }
+    return 0;
+}
+
+/*-------------------------------------------------------------
+ * Argument checks of the fused functions
+*-------------------------------------------------------------*/
+static cipher_status_t validate_packed(const void *in, const void *out,
+                                       size_t len, int key)
+{
+    if (in == NULL || out == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (key <= 0) {
+        return CIPHER_ERROR_INVALID_KEY;
+    }
+    if (len > CIPHER_MAX_INPUT_LEN) {
+        return CIPHER_ERROR_INVALID_LENGTH;
+    }
+    return CIPHER_SUCCESS;
+}
+
+/*-------------------------------------------------------------
+ * Public
+*-------------------------------------------------------------*/
+cipher_status_t cipher_pack(const char *in, size_t len, unsigned char *out)
+{
+    pack_writer_t w;
+    unsigned code;
+    size_t i;
+
+    if (in == NULL || out == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+
+    writer_init(&w, out);
+    for (i = 0; i < len; i++) {
+        code = SYMBOL_CODE[(unsigned char)in[i]];
+        if (code == 0U) {
+            return CIPHER_ERROR_INVALID_CHAR;
+        }
+        put_code(&w, code - 1U);
+    }
+    writer_finish(&w);
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_unpack(const unsigned char *in, size_t len, char *out)
+{
+    pack_reader_t r;
+    int code;
+    size_t i;
+
+    if (in == NULL || out == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+
+    reader_init(&r, in, len);
+    for (i = 0; i < len; i++) {
+        code = get_code(&r);
+        if (code < 0) {
+            return CIPHER_ERROR_INVALID_CHAR;
+        }
+        out[i] = CODE_SYMBOL[code];
+    }
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_encrypt_packed(const char *in, size_t len, int key,
+                                      unsigned char *out)
+{
+    cipher_shift_schedule_t sched;
+    pack_writer_t w;
+    size_t lower, k_lo, k_up;
+    cipher_status_t status = validate_packed(in, out, len, key);
+
+    if (status != CIPHER_SUCCESS) {
+        return status;
+    }
+
+    cipher_shift_schedule(&sched, len, key);
+    lower = sched.lower;
+    k_lo  = sched.lower_rot;
+    k_up  = sched.upper_rot;
+
+    /* Ciphertext order: each half read from its rotation point onwards */
+    writer_init(&w, out);
+    if (pack_run(&w, in + k_lo, lower - k_lo, cipher_forward_map) != 0 ||
+        pack_run(&w, in, k_lo, cipher_forward_map) != 0 ||
+        pack_run(&w, in + lower + k_up, len - lower - k_up,
+                 cipher_forward_map) != 0 ||
+        pack_run(&w, in + lower, k_up, cipher_forward_map) != 0) {
+        return CIPHER_ERROR_INVALID_CHAR;
+    }
+    writer_finish(&w);
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_decrypt_packed(const unsigned char *in, size_t len,
+                                      int key, char *out)
+{
+    cipher_shift_schedule_t sched;
+    pack_reader_t r;
+    size_t lower, k_lo, k_up;
+    cipher_status_t status = validate_packed(in, out, len, key);
+
+    if (status != CIPHER_SUCCESS) {
+        return status;
+    }
+
+    cipher_shift_schedule(&sched, len, key);
+    lower = sched.lower;
+    k_lo  = sched.lower_rot;
+    k_up  = sched.upper_rot;
+
+    /* Each symbol goes straight back to its plaintext offset */
+    reader_init(&r, in, len);
+    if (unpack_run(&r, out + k_lo, lower - k_lo, cipher_reverse_map) != 0 ||
+        unpack_run(&r, out, k_lo, cipher_reverse_map) != 0 ||
+        unpack_run(&r, out + lower + k_up, len - lower - k_up,
+                   cipher_reverse_map) != 0 ||
+        unpack_run(&r, out + lower, k_up, cipher_reverse_map) != 0) {
+        return CIPHER_ERROR_INVALID_CHAR;
+    }
+    return CIPHER_SUCCESS;
+}
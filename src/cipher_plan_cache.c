@@ -0,0 +1,182 @@
+/**
+ * @file cipher_plan_cache.c
+ * @brief Bounded (length, key) plan cache with LRU eviction.
+ *
+ * See cipher_plan_cache.h for usage notes.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#include "cipher_plan_cache.h"
+#include "cipher_internal.h"
+
+#include <string.h>
+
+#if CIPHER_ENABLE_STATS
+#define STATS_PLAN(h, m, e) cipher_stats_plan_cache((h), (m), (e))
+#else
+#define STATS_PLAN(h, m, e) ((void)0)
+#endif
+
+/*-------------------------------------------------------------
+ * Arena layout
+ *
+ * Plans are packed from the start of the arena in entry order,
+ * so the free space is always one block at the end. Evicting
+ * entry k slides the index tables after it down over its own
+ * and renumbers the entries; lookups can then append without
+ * ever searching for a hole.
+*-------------------------------------------------------------*/
+static void cache_remove(cipher_plan_cache_t *cache, size_t k)
+{
+    cipher_index_t *base = cache->entry[k].plan.index;
+    size_t n    = cache->entry[k].plan.len;
+    size_t tail = cache->used - (size_t)(base - cache->arena) - n;
+    size_t j;
+
+    memmove(base, base + n, tail * sizeof *base);
+    for (j = k + 1U; j < cache->count; j++) {
+        cache->entry[j - 1U] = cache->entry[j];
+        cache->entry[j - 1U].plan.index -= n;
+    }
+    cache->used -= n;
+    cache->count--;
+}
+
+/* Least recently used entry: the largest age, which survives clock wrap */
+static size_t cache_lru(const cipher_plan_cache_t *cache)
+{
+    size_t lru = 0U;
+    size_t j;
+
+    for (j = 1U; j < cache->count; j++) {
+        if ((uint32_t)(cache->clock - cache->entry[j].last_use) >
+            (uint32_t)(cache->clock - cache->entry[lru].last_use)) {
+            lru = j;
+        }
+    }
+    return lru;
+}
+
+/*-------------------------------------------------------------
+ * Public
+*-------------------------------------------------------------*/
+cipher_status_t cipher_plan_cache_init(cipher_plan_cache_t *cache,
+                                       cipher_index_t *arena, size_t arena_len)
+{
+    if (cache == NULL || arena == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (arena_len == 0U) {
+        return CIPHER_ERROR_INVALID_LENGTH;
+    }
+
+    memset(cache, 0, sizeof *cache);
+    cache->arena    = arena;
+    cache->capacity = arena_len;
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_plan_cache_get(cipher_plan_cache_t *cache, size_t len,
+                                      int key, const cipher_plan_t **plan)
+{
+    cipher_status_t status;
+    uint32_t evicted = 0U;
+    size_t j;
+
+    if (cache == NULL || plan == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (key <= 0) {
+        return CIPHER_ERROR_INVALID_KEY;
+    }
+    if (len > CIPHER_MAX_INPUT_LEN || len > cache->capacity) {
+        return CIPHER_ERROR_INVALID_LENGTH;
+    }
+
+    cache->clock++;
+    for (j = 0; j < cache->count; j++) {
+        if (cache->entry[j].plan.len == len && cache->entry[j].plan.key == key) {
+            cache->entry[j].last_use = cache->clock;
+            cache->stats.hits++;
+            STATS_PLAN(1U, 0U, 0U);
+            *plan = &cache->entry[j].plan;
+            return CIPHER_SUCCESS;
+        }
+    }
+
+    while (cache->count == CIPHER_PLAN_CACHE_ENTRIES ||
+           cache->capacity - cache->used < len) {
+        cache_remove(cache, cache_lru(cache));
+        evicted++;
+    }
+
+    j = cache->count;
+    status = cipher_plan_init(&cache->entry[j].plan, cache->arena + cache->used,
+                              len, key);
+    if (status != CIPHER_SUCCESS) {
+        return status;
+    }
+    cache->entry[j].last_use = cache->clock;
+    cache->used += len;
+    cache->count++;
+
+    cache->stats.misses++;
+    cache->stats.evictions += evicted;
+    STATS_PLAN(0U, 1U, evicted);
+    *plan = &cache->entry[j].plan;
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_plan_cache_encrypt(cipher_plan_cache_t *cache,
+                                          const char *in, char *out,
+                                          size_t len, int key)
+{
+    const cipher_plan_t *plan;
+    cipher_status_t status;
+
+    if (cache == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (len > cache->capacity && len <= CIPHER_MAX_INPUT_LEN) {
+        cache->stats.misses++;
+        STATS_PLAN(0U, 1U, 0U);
+        return cipher_encrypt_to(in, out, len, key);
+    }
+
+    status = cipher_plan_cache_get(cache, len, key, &plan);
+    if (status != CIPHER_SUCCESS) {
+        return status;
+    }
+    return cipher_plan_encrypt(plan, in, out);
+}
+
+cipher_status_t cipher_plan_cache_decrypt(cipher_plan_cache_t *cache,
+                                          const char *in, char *out,
+                                          size_t len, int key)
+{
+    const cipher_plan_t *plan;
+    cipher_status_t status;
+
+    if (cache == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (len > cache->capacity && len <= CIPHER_MAX_INPUT_LEN) {
+        cache->stats.misses++;
+        STATS_PLAN(0U, 1U, 0U);
+        return cipher_decrypt_to(in, out, len, key);
+    }
+
+    status = cipher_plan_cache_get(cache, len, key, &plan);
+    if (status != CIPHER_SUCCESS) {
+        return status;
+    }
+    return cipher_plan_decrypt(plan, in, out);
+}
+
+void cipher_plan_cache_stats(const cipher_plan_cache_t *cache,
+                             cipher_plan_cache_stats_t *snapshot)
+{
+    if (cache != NULL && snapshot != NULL) {
+        *snapshot = cache->stats;
+    }
+}
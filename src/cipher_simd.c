@@ -0,0 +1,295 @@
+/**
+ * @file cipher_simd.c
+ * @brief Vectorised substitution kernels for host builds.
+ *
+ * A 256-entry direct map is applied 16 (SSE4.1, NEON) or 32 (AVX2) bytes at
+ * a time with a nibble split: the low nibble of each byte indexes one
+ * 16-byte row of the map through a byte shuffle (pshufb / vtbl), and the
+ * high nibble selects which row's result is kept. The map is the identity
+ * outside the [lo, hi] span the caller passes (the built-in spans are
+ * constants, a context's are computed once by cipher_ctx_init()), so only
+ * rows lo >> 4 .. hi >> 4 are loaded and applied: the built-in alphabet
+ * costs three shuffles per vector, with no scan of the map per call.
+ *
+ * The maps send bytes outside the alphabet to themselves, so the range
+ * check is a single compare of the result against the input, done in the
+ * same loop. In stop mode the vector holding the first invalid byte is not
+ * stored; the scalar kernel finishes up to that byte and stops.
+ *
+ * The kernel is chosen at run time from the CPU feature flags, probed once
+ * and cached; the scalar loop handles tails, short buffers and CPUs
+ * without the extensions.
+ * Bare-metal builds compile this file to nothing (CIPHER_USE_SIMD == 0).
+ *
+ * @author Rushikesh Kaduskar
+ */
+#include "cipher_internal.h"
+
+#if CIPHER_USE_SIMD
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CIPHER_SIMD_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CIPHER_SIMD_NEON 1
+#endif
+
+/* -------------------------------------------------------------------------
+ * scalar kernel: buf[begin .. len-1], tracking the first invalid byte
+ * ---------------------------------------------------------------------- */
+static size_t substitute_scalar(unsigned char *buf, size_t begin, size_t len,
+                                const unsigned char map[256], size_t first_bad,
+                                int stop)
+{
+    size_t i;
+    unsigned char c;
+
+    for (i = begin; i < len; i++) {
+        c = map[buf[i]];
+        if (first_bad == len && c == buf[i]) {
+            first_bad = i;
+            if (stop) {
+                break;
+            }
+        }
+        buf[i] = c;
+    }
+    return first_bad;
+}
+
+#if defined(CIPHER_SIMD_X86)
+
+/* -------------------------------------------------------------------------
+ * SSE4.1: pshufb lookup per active row, blendv on the high nibble
+ * ---------------------------------------------------------------------- */
+__attribute__((target("sse4.1")))
+static size_t substitute_sse41(unsigned char *buf, size_t len,
+                               const unsigned char map[256], unsigned lo,
+                               unsigned hi, int stop)
+{
+    const __m128i low_mask = _mm_set1_epi8(0x0F);
+    __m128i rows[16];
+    __m128i tags[16];
+    size_t first_bad = len;
+    size_t nrows = 0U;
+    size_t h, i;
+
+    for (h = lo >> 4; h <= (hi >> 4) && lo <= hi; h++) {
+        rows[nrows] = _mm_loadu_si128((const __m128i *)(const void *)(map + 16U * h));
+        tags[nrows] = _mm_set1_epi8((char)h);
+        nrows++;
+    }
+
+    for (i = 0U; i + 16U <= len; i += 16U) {
+        __m128i v      = _mm_loadu_si128((const __m128i *)(void *)(buf + i));
+        __m128i nib_lo = _mm_and_si128(v, low_mask);
+        __m128i nib_hi = _mm_and_si128(_mm_srli_epi16(v, 4), low_mask);
+        __m128i r      = v;
+
+        for (h = 0U; h < nrows; h++) {
+            r = _mm_blendv_epi8(r, _mm_shuffle_epi8(rows[h], nib_lo),
+                                _mm_cmpeq_epi8(nib_hi, tags[h]));
+        }
+
+        if (first_bad == len) {
+            unsigned bad = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(r, v));
+            if (bad != 0U) {
+                if (stop) {
+                    return substitute_scalar(buf, i, len, map, len, 1);
+                }
+                first_bad = i + (size_t)__builtin_ctz(bad);
+            }
+        }
+        _mm_storeu_si128((__m128i *)(void *)(buf + i), r);
+    }
+    return substitute_scalar(buf, i, len, map, first_bad, stop);
+}
+
+/* -------------------------------------------------------------------------
+ * AVX2: same scheme, rows broadcast to both 128-bit lanes
+ * ---------------------------------------------------------------------- */
+__attribute__((target("avx2")))
+static size_t substitute_avx2(unsigned char *buf, size_t len,
+                              const unsigned char map[256], unsigned lo,
+                              unsigned hi, int stop)
+{
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    __m256i rows[16];
+    __m256i tags[16];
+    size_t first_bad = len;
+    size_t nrows = 0U;
+    size_t h, i;
+
+    for (h = lo >> 4; h <= (hi >> 4) && lo <= hi; h++) {
+        rows[nrows] = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128((const __m128i *)(const void *)(map + 16U * h)));
+        tags[nrows] = _mm256_set1_epi8((char)h);
+        nrows++;
+    }
+
+    for (i = 0U; i + 32U <= len; i += 32U) {
+        __m256i v      = _mm256_loadu_si256((const __m256i *)(void *)(buf + i));
+        __m256i nib_lo = _mm256_and_si256(v, low_mask);
+        __m256i nib_hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+        __m256i r      = v;
+
+        for (h = 0U; h < nrows; h++) {
+            r = _mm256_blendv_epi8(r, _mm256_shuffle_epi8(rows[h], nib_lo),
+                                   _mm256_cmpeq_epi8(nib_hi, tags[h]));
+        }
+
+        if (first_bad == len) {
+            unsigned bad = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(r, v));
+            if (bad != 0U) {
+                if (stop) {
+                    return substitute_scalar(buf, i, len, map, len, 1);
+                }
+                first_bad = i + (size_t)__builtin_ctz(bad);
+            }
+        }
+        _mm256_storeu_si256((__m256i *)(void *)(buf + i), r);
+    }
+    return substitute_scalar(buf, i, len, map, first_bad, stop);
+}
+
+#elif defined(CIPHER_SIMD_NEON)
+
+/* -------------------------------------------------------------------------
+ * NEON helpers (AArch64 vqtbl1q, ARMv7 vtbl2 on the two halves)
+ * ---------------------------------------------------------------------- */
+static int neon_any(uint8x16_t m)
+{
+#if defined(__aarch64__)
+    return vmaxvq_u8(m) != 0U;
+#else
+    uint32x2_t f = vpmax_u32(vget_low_u32(vreinterpretq_u32_u8(m)),
+                             vget_high_u32(vreinterpretq_u32_u8(m)));
+    return vget_lane_u32(vpmax_u32(f, f), 0) != 0U;
+#endif
+}
+
+static uint8x16_t neon_lookup(uint8x16_t row, uint8x16_t idx)
+{
+#if defined(__aarch64__)
+    return vqtbl1q_u8(row, idx);
+#else
+    uint8x8x2_t t;
+    t.val[0] = vget_low_u8(row);
+    t.val[1] = vget_high_u8(row);
+    return vcombine_u8(vtbl2_u8(t, vget_low_u8(idx)),
+                       vtbl2_u8(t, vget_high_u8(idx)));
+#endif
+}
+
+static size_t substitute_neon(unsigned char *buf, size_t len,
+                              const unsigned char map[256], unsigned lo,
+                              unsigned hi, int stop)
+{
+    const uint8x16_t low_mask = vdupq_n_u8(0x0F);
+    uint8x16_t rows[16];
+    uint8x16_t tags[16];
+    unsigned char lanes[16];
+    size_t first_bad = len;
+    size_t nrows = 0U;
+    size_t h, i, j;
+
+    for (h = lo >> 4; h <= (hi >> 4) && lo <= hi; h++) {
+        rows[nrows] = vld1q_u8(map + 16U * h);
+        tags[nrows] = vdupq_n_u8((unsigned char)h);
+        nrows++;
+    }
+
+    for (i = 0U; i + 16U <= len; i += 16U) {
+        uint8x16_t v      = vld1q_u8(buf + i);
+        uint8x16_t nib_lo = vandq_u8(v, low_mask);
+        uint8x16_t nib_hi = vshrq_n_u8(v, 4);
+        uint8x16_t r      = v;
+        uint8x16_t bad;
+
+        for (h = 0U; h < nrows; h++) {
+            r = vbslq_u8(vceqq_u8(nib_hi, tags[h]),
+                         neon_lookup(rows[h], nib_lo), r);
+        }
+
+        if (first_bad == len) {
+            bad = vceqq_u8(r, v);
+            if (neon_any(bad)) {
+                if (stop) {
+                    return substitute_scalar(buf, i, len, map, len, 1);
+                }
+                vst1q_u8(lanes, bad);
+                j = 0U;
+                while (lanes[j] == 0U) {
+                    j++;
+                }
+                first_bad = i + j;
+            }
+        }
+        vst1q_u8(buf + i, r);
+    }
+    return substitute_scalar(buf, i, len, map, first_bad, stop);
+}
+
+#endif
+
+/* -------------------------------------------------------------------------
+ * Dispatch
+ * ---------------------------------------------------------------------- */
+#if defined(CIPHER_SIMD_X86)
+#define SIMD_PROBED 0x1U
+#define SIMD_SSE41  0x2U
+#define SIMD_AVX2   0x4U
+
+/*
+ * CPU features, probed on first use. Every thread that races the probe
+ * stores the same value, and the atomics keep that benign for the
+ * memory model (and for TSan).
+ */
+static unsigned simd_features(void)
+{
+    static unsigned features;
+    unsigned f = __atomic_load_n(&features, __ATOMIC_RELAXED);
+
+    if (f == 0U) {
+        f = SIMD_PROBED;
+        if (__builtin_cpu_supports("sse4.1")) {
+            f |= SIMD_SSE41;
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            f |= SIMD_AVX2;
+        }
+        __atomic_store_n(&features, f, __ATOMIC_RELAXED);
+    }
+    return f;
+}
+#endif
+
+size_t cipher_simd_substitute(unsigned char *buf, size_t len,
+                              const unsigned char map[256], unsigned lo,
+                              unsigned hi, int stop)
+{
+#if defined(CIPHER_SIMD_X86)
+    if (len >= 16U) {
+        unsigned f = simd_features();
+
+        if (len >= 32U && (f & SIMD_AVX2) != 0U) {
+            return substitute_avx2(buf, len, map, lo, hi, stop);
+        }
+        if ((f & SIMD_SSE41) != 0U) {
+            return substitute_sse41(buf, len, map, lo, hi, stop);
+        }
+    }
+#elif defined(CIPHER_SIMD_NEON)
+    if (len >= 16U) {
+        return substitute_neon(buf, len, map, lo, hi, stop);
+    }
+#endif
+    return substitute_scalar(buf, 0U, len, map, len, stop);
+}
+
+#else
+
+typedef int cipher_simd_unused_t;   /* ISO C forbids an empty translation unit */
+
+#endif
@@ -0,0 +1,136 @@
+/**
+ * @file cipher_stream.c
+ * @brief Chunked encryption for payloads larger than CIPHER_MAX_INPUT_LEN.
+ *
+ * See cipher_stream.h for usage notes.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#include "cipher_stream.h"
+#include "cipher_internal.h"
+
+/*-------------------------------------------------------------
+ * Common init
+*-------------------------------------------------------------*/
+static cipher_status_t stream_init(cipher_stream_t *stream, size_t total_len,
+                                   int key, cipher_stream_emit_fn emit,
+                                   void *user, int decrypt)
+{
+    cipher_shift_schedule_t sched;
+
+    if (stream == NULL || emit == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (key <= 0) {
+        return CIPHER_ERROR_INVALID_KEY;
+    }
+
+    cipher_shift_schedule(&sched, total_len, key);
+    if (decrypt) {
+        cipher_shift_schedule_invert(&sched, total_len);
+    }
+
+    stream->total_len = total_len;
+    stream->pos       = 0U;
+    stream->lower     = sched.lower;
+    stream->lower_rot = sched.lower_rot;
+    stream->upper_rot = sched.upper_rot;
+    stream->map       = decrypt ? cipher_reverse_map : cipher_forward_map;
+    stream->emit      = emit;
+    stream->user      = user;
+    return CIPHER_SUCCESS;
+}
+
+/*-------------------------------------------------------------
+ * Emit `len` substituted bytes that land contiguously at `dest`
+*-------------------------------------------------------------*/
+static void emit_run(cipher_stream_t *stream, const char *in, size_t len,
+                     size_t dest)
+{
+    size_t n, i;
+
+    while (len > 0U) {
+        n = (len < CIPHER_STREAM_BLOCK) ? len : CIPHER_STREAM_BLOCK;
+        for (i = 0U; i < n; i++) {
+            stream->block[i] = (char)stream->map[(unsigned char)in[i]];
+        }
+        stream->emit(stream->user, dest, stream->block, n);
+        in   += n;
+        dest += n;
+        len  -= n;
+    }
+}
+
+/*-------------------------------------------------------------
+ * Public
+*-------------------------------------------------------------*/
+cipher_status_t cipher_stream_encrypt_init(cipher_stream_t *stream,
+                                           size_t total_len, int key,
+                                           cipher_stream_emit_fn emit,
+                                           void *user)
+{
+    return stream_init(stream, total_len, key, emit, user, 0);
+}
+
+cipher_status_t cipher_stream_decrypt_init(cipher_stream_t *stream,
+                                           size_t total_len, int key,
+                                           cipher_stream_emit_fn emit,
+                                           void *user)
+{
+    return stream_init(stream, total_len, key, emit, user, 1);
+}
+
+cipher_status_t cipher_stream_update(cipher_stream_t *stream,
+                                     const char *chunk, size_t len)
+{
+    size_t base, size, rot, off, run, dest;
+
+    if (stream == NULL || chunk == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (len > stream->total_len - stream->pos) {
+        return CIPHER_ERROR_INVALID_LENGTH;
+    }
+
+    while (len > 0U) {
+        /* Which half, and where its rotation splits it */
+        if (stream->pos < stream->lower) {
+            base = 0U;
+            size = stream->lower;
+            rot  = stream->lower_rot;
+        } else {
+            base = stream->lower;
+            size = stream->total_len - stream->lower;
+            rot  = stream->upper_rot;
+        }
+
+        /* Input [base, base+rot) wraps to the end of the half, the rest
+         * moves down by `rot`; each piece lands contiguously. */
+        off = stream->pos - base;
+        if (off < rot) {
+            run  = rot - off;
+            dest = base + size - rot + off;
+        } else {
+            run  = size - off;
+            dest = base + off - rot;
+        }
+        if (run > len) {
+            run = len;
+        }
+
+        emit_run(stream, chunk, run, dest);
+        stream->pos += run;
+        chunk       += run;
+        len         -= run;
+    }
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_stream_final(const cipher_stream_t *stream)
+{
+    if (stream == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    return (stream->pos == stream->total_len) ? CIPHER_SUCCESS
+                                              : CIPHER_ERROR_INVALID_LENGTH;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file cipher_tx.c
+ * @brief Encrypt-ahead ring for DMA-driven transmit paths.
+ *
+ * See cipher_tx.h for usage notes.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#include "cipher_tx.h"
+
+/*-------------------------------------------------------------
+ * Ordering
+ *
+ * Every counter has a single writer, so plain loads and stores
+ * of size_t suffice; the barrier keeps the slot contents and
+ * the counters in program order for the other context (and for
+ * the DMA master).
+*-------------------------------------------------------------*/
+#if defined(__GNUC__)
+#define TX_BARRIER() __sync_synchronize()
+#else
+#define TX_BARRIER() ((void)0)      /* port: a full memory barrier */
+#endif
+
+/*-------------------------------------------------------------
+ * Link state
+ *
+ * kicked + chained counts transfers started, tail transfers
+ * finished. The link is idle exactly when the two are equal,
+ * and while it is idle no completion ISR can run, so the
+ * producer may start it without racing the ISR. tail must be
+ * read before the start counts: a completion landing between
+ * the reads can then only make the link look busy, and that
+ * completion itself chains the next frame.
+*-------------------------------------------------------------*/
+static void tx_start(cipher_tx_t *tx, size_t index)
+{
+    const cipher_span_t *slot = &tx->slots[index & (tx->count - 1U)];
+
+    tx->start(tx->user, slot->data, slot->len);
+}
+
+/* Producer side: start the link if it is idle and a frame is queued */
+static void tx_kick(cipher_tx_t *tx)
+{
+    size_t tail = tx->tail;
+
+    TX_BARRIER();
+    if (tx->kicked + tx->chained == tail && tail != tx->head) {
+        tx->kicked++;
+        TX_BARRIER();
+        tx_start(tx, tail);
+    }
+}
+
+/*-------------------------------------------------------------
+ * Public
+*-------------------------------------------------------------*/
+cipher_status_t cipher_tx_init(cipher_tx_t *tx, cipher_span_t *slots,
+                               size_t count, size_t capacity, int key,
+                               cipher_tx_start_fn start, void *user)
+{
+    size_t i;
+
+    if (tx == NULL || slots == NULL || start == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (key <= 0) {
+        return CIPHER_ERROR_INVALID_KEY;
+    }
+    /* A power of two keeps slot = counter % count consistent across
+     * counter wrap-around. */
+    if (count == 0U || (count & (count - 1U)) != 0U ||
+        capacity > CIPHER_MAX_INPUT_LEN) {
+        return CIPHER_ERROR_INVALID_LENGTH;
+    }
+    for (i = 0; i < count; i++) {
+        if (slots[i].data == NULL) {
+            return CIPHER_ERROR_NULL_POINTER;
+        }
+    }
+
+    tx->slots    = slots;
+    tx->count    = count;
+    tx->capacity = capacity;
+    tx->key      = key;
+    tx->start    = start;
+    tx->user     = user;
+    tx->head     = 0U;
+    tx->kicked   = 0U;
+    tx->tail     = 0U;
+    tx->chained  = 0U;
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_tx_submit(cipher_tx_t *tx, const char *frame, size_t len)
+{
+    cipher_span_t *slot;
+    cipher_status_t status;
+    size_t head;
+
+    if (tx == NULL || frame == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (len > tx->capacity) {
+        return CIPHER_ERROR_INVALID_LENGTH;
+    }
+
+    head = tx->head;
+    if (head - tx->tail >= tx->count) {
+        return CIPHER_BUSY;
+    }
+    TX_BARRIER();                       /* slot is free before reuse */
+
+    slot = &tx->slots[head & (tx->count - 1U)];
+    status = cipher_encrypt_to(frame, slot->data, len, tx->key);
+    if (status != CIPHER_SUCCESS) {
+        return status;
+    }
+    slot->len = len;
+
+    TX_BARRIER();                       /* slot complete before publish */
+    tx->head = head + 1U;
+    TX_BARRIER();
+    tx_kick(tx);
+    return CIPHER_SUCCESS;
+}
+
+void cipher_tx_complete(cipher_tx_t *tx)
+{
+    size_t tail;
+
+    if (tx == NULL) {
+        return;
+    }
+
+    tail = tx->tail + 1U;
+    TX_BARRIER();
+    tx->tail = tail;                    /* frees the slot just sent */
+    TX_BARRIER();
+    if (tail != tx->head) {
+        tx->chained++;
+        TX_BARRIER();
+        tx_start(tx, tail);
+    }
+}
+
+size_t cipher_tx_pending(const cipher_tx_t *tx)
+{
+    return (tx != NULL) ? tx->head - tx->tail : 0U;
+}
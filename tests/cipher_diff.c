@@ -0,0 +1,625 @@
+/**
+ * @file cipher_diff.c
+ * @brief Differential check of every library entry point against the
+ *        frozen reference; see cipher_diff.h.
+ *
+ * @author Rushikesh Kaduskar
+ */
+
+#include "cipher_diff.h"
+#include "cipher_ref.h"
+#include "cipher_job.h"
+#include "cipher_pack.h"
+#include "cipher_plan_cache.h"
+#include "cipher_stream.h"
+#include "cipher_tx.h"
+
+#include <string.h>
+
+#define MAX_FRAMES     16U
+#define MAX_FRAGS      8U
+#define CACHE_ARENA    4096U
+
+#define CHECK(cond, name)             \
+    do {                              \
+        if (!(cond)) {                \
+            return (name);            \
+        }                             \
+    } while (0)
+
+/* -------------------------------------------------------------------------
+ * Scratch state (static: keeps the fuzzer's stack small)
+ * ---------------------------------------------------------------------- */
+
+static char            in[CIPHER_DIFF_MAX_LEN + 1U];
+static char            expect[2][CIPHER_DIFF_MAX_LEN];     /* [decrypt] */
+static cipher_status_t expect_status;
+static char            work[CIPHER_DIFF_MAX_LEN + 1U];
+static char            out[CIPHER_DIFF_MAX_LEN + 1U];
+static char            expect64[CIPHER_DIFF_MAX_LEN];
+static unsigned char   packed[CIPHER_PACKED_SIZE(CIPHER_DIFF_MAX_LEN)];
+static cipher_index_t  plan_storage[CIPHER_MAX_INPUT_LEN];
+static cipher_index_t  cache_arena[CACHE_ARENA];
+static cipher_plan_cache_t cache;
+static int             cache_ready;
+static cipher_key_t    handle;
+static int             handle_key;  /* 0: handle not initialised */
+static uint32_t        rng;
+
+static uint32_t next(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/** Uniform in [0, n], n may be 0. */
+static size_t pick(size_t n)
+{
+    return (size_t)(next() % (uint32_t)(n + 1U));
+}
+
+/** Status and bytes: the expected output on success, the input on error. */
+static int matches(cipher_status_t got, cipher_status_t want,
+                   const char *buf, size_t len, int decrypt)
+{
+    const char *ref = (want == CIPHER_SUCCESS) ? expect[decrypt] : in;
+
+    return got == want && memcmp(buf, ref, len) == 0;
+}
+
+/** Random partition of [0, len) into `count` + 1 boundaries. */
+static size_t split(size_t len, size_t *bound, size_t max_parts)
+{
+    size_t count = 1U + pick(max_parts - 1U);
+    size_t i, j;
+
+    bound[0] = 0;
+    bound[count] = len;
+    for (i = 1; i < count; i++) {
+        bound[i] = pick(len);
+    }
+    for (i = 1; i < count; i++) {           /* insertion sort, tiny */
+        for (j = i; j > 1 && bound[j - 1] > bound[j]; j--) {
+            size_t t = bound[j];
+            bound[j] = bound[j - 1];
+            bound[j - 1] = t;
+        }
+    }
+    return count;
+}
+
+/* -------------------------------------------------------------------------
+ * Whole-buffer entry points
+ * ---------------------------------------------------------------------- */
+
+typedef cipher_status_t (*buf_fn)(char *buf, size_t len, int key);
+typedef cipher_status_t (*to_fn)(const char *in, char *out, size_t len,
+                                 int key);
+
+/** In place, under every kernel this build can dispatch to. */
+static const char *check_buf(size_t len, int key)
+{
+    static const buf_fn fn[2] = { cipher_encrypt_buf, cipher_decrypt_buf };
+    static const char *const name[CIPHER_KERNEL_COUNT][2] = {
+        { "encrypt_buf[scalar]", "decrypt_buf[scalar]" },
+        { "encrypt_buf[swar]",   "decrypt_buf[swar]"   },
+        { "encrypt_buf[simd]",   "decrypt_buf[simd]"   },
+        { "encrypt_buf[gather]", "decrypt_buf[gather]" }
+    };
+    cipher_tune_t table;
+    unsigned k;
+    int d;
+
+    for (d = 0; d < 2; d++) {
+        memcpy(work, in, len);
+        CHECK(matches(fn[d](work, len, key), expect_status, work, len, d),
+              d ? "decrypt_buf" : "encrypt_buf");
+    }
+    for (k = 0; k < CIPHER_KERNEL_COUNT; k++) {
+        memset(table.kernel, (int)k, sizeof(table.kernel));
+        if (cipher_tune_use(&table) != CIPHER_SUCCESS) {
+            continue;                       /* kernel not in this build */
+        }
+        for (d = 0; d < 2; d++) {
+            memcpy(work, in, len);
+            if (!matches(fn[d](work, len, key), expect_status, work, len, d)) {
+                (void)cipher_tune_use(NULL);
+                return name[k][d];
+            }
+        }
+    }
+    (void)cipher_tune_use(NULL);
+    return NULL;
+}
+
+static cipher_status_t ctx_encrypt_to(const char *src, char *dst, size_t len,
+                                      int key)
+{
+    return cipher_ctx_encrypt_to(&cipher_default_ctx, src, dst, len, key);
+}
+
+static cipher_status_t ctx_decrypt_to(const char *src, char *dst, size_t len,
+                                      int key)
+{
+    return cipher_ctx_decrypt_to(&cipher_default_ctx, src, dst, len, key);
+}
+
+static cipher_status_t cache_encrypt(const char *src, char *dst, size_t len,
+                                     int key)
+{
+    return cipher_plan_cache_encrypt(&cache, src, dst, len, key);
+}
+
+static cipher_status_t cache_decrypt(const char *src, char *dst, size_t len,
+                                     int key)
+{
+    return cipher_plan_cache_decrypt(&cache, src, dst, len, key);
+}
+
+/** Out of place (and aliased in == out) through _to, ctx and plan cache. */
+static const char *check_to(size_t len, int key)
+{
+    static const to_fn fn[3][2] = {
+        { cipher_encrypt_to, cipher_decrypt_to },
+        { ctx_encrypt_to,    ctx_decrypt_to    },
+        { cache_encrypt,     cache_decrypt     }
+    };
+    static const char *const name[3][2] = {
+        { "encrypt_to",       "decrypt_to"       },
+        { "ctx_encrypt_to",   "ctx_decrypt_to"   },
+        { "plan_cache_encrypt", "plan_cache_decrypt" }
+    };
+    size_t v;
+    int d;
+
+    if (!cache_ready) {
+        (void)cipher_plan_cache_init(&cache, cache_arena, CACHE_ARENA);
+        cache_ready = 1;
+    }
+    for (v = 0; v < 3U; v++) {
+        for (d = 0; d < 2; d++) {
+            memcpy(out, in, len);
+            CHECK(matches(fn[v][d](in, out, len, key), expect_status,
+                          out, len, d), name[v][d]);
+            memcpy(work, in, len);
+            CHECK(matches(fn[v][d](work, work, len, key), expect_status,
+                          work, len, d), name[v][d]);
+        }
+    }
+    for (d = 0; d < 2; d++) {
+        memcpy(work, in, len);
+        CHECK(matches(d ? cipher_ctx_decrypt_buf(&cipher_default_ctx, work,
+                                                 len, key)
+                        : cipher_ctx_encrypt_buf(&cipher_default_ctx, work,
+                                                 len, key),
+                      expect_status, work, len, d),
+              d ? "ctx_decrypt_buf" : "ctx_encrypt_buf");
+    }
+    return NULL;
+}
+
+/** Null-terminated entry points, when the input has no NUL of its own. */
+static const char *check_string(size_t len, int key)
+{
+    size_t i;
+    int d;
+
+    if (memchr(in, '\0', len) != NULL) {
+        return NULL;
+    }
+    for (d = 0; d < 2; d++) {
+        cipher_status_t want, got;
+
+        memcpy(out, in, len + 1U);
+        memcpy(work, in, len + 1U);
+        want = d ? cipher_ref_decrypt(out, key) : cipher_ref_encrypt(out, key);
+        got = d ? cipher_decrypt(work, key) : cipher_encrypt(work, key);
+        CHECK(got == want && memcmp(work, out, len + 1U) == 0,
+              d ? "decrypt" : "encrypt");
+    }
+
+    /* Uppercase: the reference of the folded input. */
+    for (i = 0; i < len; i++) {
+        char c = in[i];
+        out[i] = (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+    }
+    (void)cipher_ref_encrypt_buf(out, len, key);
+    memcpy(work, in, len);
+    work[len] = '\0';
+    if (expect_status == CIPHER_SUCCESS) {
+        CHECK(cipher_encrypt_uppercase(work, key) == CIPHER_SUCCESS &&
+              memcmp(work, out, len) == 0, "encrypt_uppercase");
+    } else {
+        CHECK(cipher_encrypt_uppercase(work, key) == expect_status,
+              "encrypt_uppercase");
+    }
+    memcpy(work, in, len);
+    if (expect_status == CIPHER_SUCCESS) {
+        CHECK(cipher_encrypt_uppercase_buf(work, len, key) == CIPHER_SUCCESS &&
+              memcmp(work, out, len) == 0, "encrypt_uppercase_buf");
+    } else {
+        CHECK(cipher_encrypt_uppercase_buf(work, len, key) == expect_status,
+              "encrypt_uppercase_buf");
+    }
+    return NULL;
+}
+
+/**
+ * 64-bit keys: the widened int key must give the int API's result, and a
+ * key with random high bits the reference's plain 64-bit modulo.
+ */
+static const char *check_key64(size_t len, int key)
+{
+    uint64_t narrow = key > 0 ? (uint64_t)key : 0U;
+    uint64_t wide = ((uint64_t)next() << 32) | (uint32_t)key;
+    cipher_status_t want;
+    int d;
+
+    for (d = 0; d < 2; d++) {
+        memcpy(work, in, len);
+        CHECK(matches(d ? cipher_decrypt_buf64(work, len, narrow)
+                        : cipher_encrypt_buf64(work, len, narrow),
+                      expect_status, work, len, d),
+              d ? "decrypt_buf64(int key)" : "encrypt_buf64(int key)");
+
+        memcpy(expect64, in, len);
+        want = d ? cipher_ref_decrypt_buf64(expect64, len, wide)
+                 : cipher_ref_encrypt_buf64(expect64, len, wide);
+        memcpy(work, in, len);
+        CHECK((d ? cipher_decrypt_buf64(work, len, wide)
+                 : cipher_encrypt_buf64(work, len, wide)) == want &&
+              memcmp(work, want == CIPHER_SUCCESS ? expect64 : in, len) == 0,
+              d ? "decrypt_buf64" : "encrypt_buf64");
+        memcpy(out, in, len);
+        CHECK((d ? cipher_decrypt_to64(in, out, len, wide)
+                 : cipher_encrypt_to64(in, out, len, wide)) == want &&
+              memcmp(out, want == CIPHER_SUCCESS ? expect64 : in, len) == 0,
+              d ? "decrypt_to64" : "encrypt_to64");
+        if (memchr(in, '\0', len) == NULL) {
+            memcpy(work, in, len + 1U);
+            CHECK((d ? cipher_decrypt64(work, wide)
+                     : cipher_encrypt64(work, wide)) == want &&
+                  memcmp(work, want == CIPHER_SUCCESS ? expect64 : in, len) == 0,
+                  d ? "decrypt64" : "encrypt64");
+        }
+    }
+    return NULL;
+}
+
+/** Strict mode: reference result, or the first byte outside the table. */
+static const char *check_strict(size_t len, int key)
+{
+    size_t bad = 0, got;
+    cipher_status_t want = expect_status;
+    int d;
+
+    while (bad < len && cipher_ref_in_table(in[bad])) {
+        bad++;
+    }
+    if (want == CIPHER_SUCCESS && bad < len) {
+        want = CIPHER_ERROR_INVALID_CHAR;
+    }
+    for (d = 0; d < 2; d++) {
+        memcpy(work, in, len);
+        got = (size_t)-1;
+        CHECK(matches(d ? cipher_decrypt_buf_strict(work, len, key, &got)
+                        : cipher_encrypt_buf_strict(work, len, key, &got),
+                      want, work, len, d) &&
+              (want != CIPHER_ERROR_INVALID_CHAR || got == bad),
+              d ? "decrypt_buf_strict" : "encrypt_buf_strict");
+    }
+    return NULL;
+}
+
+/** Key handle kept across calls, so its slots see many lengths. */
+static const char *check_key(size_t len, int key)
+{
+    int d;
+
+    if (key <= 0) {
+        CHECK(cipher_key_init(&handle, key) == CIPHER_ERROR_INVALID_KEY,
+              "key_init");
+        handle_key = 0;
+        return NULL;
+    }
+    if (handle_key != key) {
+        CHECK(cipher_key_init(&handle, key) == CIPHER_SUCCESS, "key_init");
+        handle_key = key;
+    }
+    for (d = 0; d < 2; d++) {
+        memcpy(work, in, len);
+        CHECK(matches(d ? cipher_key_decrypt_buf(&handle, work, len)
+                        : cipher_key_encrypt_buf(&handle, work, len),
+                      expect_status, work, len, d),
+              d ? "key_decrypt_buf" : "key_encrypt_buf");
+    }
+    return NULL;
+}
+
+static const char *check_plan(size_t len, int key)
+{
+    cipher_plan_t plan;
+    int d;
+
+    CHECK(cipher_plan_init(&plan, plan_storage, len, key) == expect_status,
+          "plan_init");
+    if (expect_status != CIPHER_SUCCESS) {
+        return NULL;
+    }
+    for (d = 0; d < 2; d++) {
+        CHECK((d ? cipher_plan_decrypt(&plan, in, out)
+                 : cipher_plan_encrypt(&plan, in, out)) == CIPHER_SUCCESS &&
+              memcmp(out, expect[d], len) == 0,
+              d ? "plan_decrypt" : "plan_encrypt");
+    }
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------
+ * Multi-frame entry points: every frame is checked on its own
+ * ---------------------------------------------------------------------- */
+
+static const char *check_frames(size_t len, int key)
+{
+    size_t          bound[MAX_FRAMES + 1U];
+    size_t          offsets[MAX_FRAMES + 1U];
+    int32_t         offsets32[MAX_FRAMES + 1U];
+    cipher_span_t   frames[MAX_FRAMES];
+    cipher_status_t status[MAX_FRAMES];
+    cipher_status_t want[MAX_FRAMES];
+    cipher_status_t first;
+    size_t count, i;
+    int d;
+
+    count = split(len, bound, MAX_FRAMES);
+    for (i = 0; i <= count; i++) {
+        offsets[i]   = bound[i];
+        offsets32[i] = (int32_t)bound[i];
+    }
+    for (d = 0; d < 2; d++) {
+        /* Per-frame reference in `out`; failing frames keep the input. */
+        memcpy(out, in, len);
+        first = CIPHER_SUCCESS;
+        for (i = 0; i < count; i++) {
+            size_t n = bound[i + 1U] - bound[i];
+            want[i] = d ? cipher_ref_decrypt_buf(out + bound[i], n, key)
+                        : cipher_ref_encrypt_buf(out + bound[i], n, key);
+            if (first == CIPHER_SUCCESS) {
+                first = want[i];
+            }
+        }
+
+        memcpy(work, in, len);
+        for (i = 0; i < count; i++) {
+            frames[i].data = work + bound[i];
+            frames[i].len  = bound[i + 1U] - bound[i];
+        }
+        CHECK((d ? cipher_decrypt_batch(frames, count, key, status)
+                 : cipher_encrypt_batch(frames, count, key, status)) == first &&
+              memcmp(status, want, count * sizeof(want[0])) == 0 &&
+              memcmp(work, out, len) == 0,
+              d ? "decrypt_batch" : "encrypt_batch");
+
+        memcpy(work, in, len);
+        CHECK((d ? cipher_decrypt_bulk(in, offsets, count, work, key, status)
+                 : cipher_encrypt_bulk(in, offsets, count, work, key, status))
+                  == first &&
+              memcmp(status, want, count * sizeof(want[0])) == 0 &&
+              memcmp(work, out, len) == 0,
+              d ? "decrypt_bulk" : "encrypt_bulk");
+
+        memcpy(work, in, len);
+        CHECK((d ? cipher_decrypt_column(work, offsets32, count, work, key,
+                                         status)
+                 : cipher_encrypt_column(work, offsets32, count, work, key,
+                                         status)) == first &&
+              memcmp(status, want, count * sizeof(want[0])) == 0 &&
+              memcmp(work, out, len) == 0,
+              d ? "decrypt_column" : "encrypt_column");
+    }
+    return NULL;
+}
+
+/** One logical message in up to MAX_FRAGS fragments (empty ones too). */
+static const char *check_iov(size_t len, int key)
+{
+    size_t        bound[MAX_FRAGS + 1U];
+    cipher_span_t frags[MAX_FRAGS];
+    size_t count, i;
+    int d;
+
+    for (d = 0; d < 2; d++) {
+        count = split(len, bound, MAX_FRAGS);
+        memcpy(work, in, len);
+        for (i = 0; i < count; i++) {
+            frags[i].data = work + bound[i];
+            frags[i].len  = bound[i + 1U] - bound[i];
+        }
+        CHECK(matches(d ? cipher_decrypt_iov(frags, count, key)
+                        : cipher_encrypt_iov(frags, count, key),
+                      expect_status, work, len, d),
+              d ? "decrypt_iov" : "encrypt_iov");
+    }
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------
+ * Incremental entry points
+ * ---------------------------------------------------------------------- */
+
+static size_t stream_len;
+static int    stream_stray;
+
+static void stream_emit(void *user, size_t offset, const char *data,
+                        size_t len)
+{
+    (void)user;
+    if (offset > stream_len || len > stream_len - offset) {
+        stream_stray = 1;
+        return;
+    }
+    memcpy(out + offset, data, len);
+}
+
+/** Streams have no length limit: compare with the unchecked transform. */
+static const char *check_stream(size_t len, int key)
+{
+    cipher_stream_t stream;
+    cipher_status_t want = (key <= 0) ? CIPHER_ERROR_INVALID_KEY
+                                      : CIPHER_SUCCESS;
+    size_t pos, n;
+    int d;
+
+    for (d = 0; d < 2; d++) {
+        CHECK((d ? cipher_stream_decrypt_init(&stream, len, key, stream_emit,
+                                              NULL)
+                 : cipher_stream_encrypt_init(&stream, len, key, stream_emit,
+                                              NULL)) == want,
+              d ? "stream_decrypt_init" : "stream_encrypt_init");
+        if (want != CIPHER_SUCCESS) {
+            continue;
+        }
+        stream_len = len;
+        stream_stray = 0;
+        memset(out, 0, len);
+        for (pos = 0; pos < len; pos += n) {
+            n = 1U + pick((len - pos - 1U) % 97U);
+            CHECK(cipher_stream_update(&stream, in + pos, n) == CIPHER_SUCCESS,
+                  "stream_update");
+        }
+        CHECK(cipher_stream_final(&stream) == CIPHER_SUCCESS, "stream_final");
+        memcpy(work, in, len);
+        cipher_ref_transform(work, len, key, d);
+        CHECK(!stream_stray && memcmp(out, work, len) == 0,
+              d ? "stream_decrypt" : "stream_encrypt");
+    }
+    return NULL;
+}
+
+static const char *check_job(size_t len, int key)
+{
+    cipher_job_t job;
+    cipher_status_t status;
+    size_t steps;
+    int d;
+
+    for (d = 0; d < 2; d++) {
+        memcpy(work, in, len);
+        CHECK((d ? cipher_job_decrypt_init(&job, work, len, key)
+                 : cipher_job_encrypt_init(&job, work, len, key))
+                  == expect_status,
+              d ? "job_decrypt_init" : "job_encrypt_init");
+        if (expect_status != CIPHER_SUCCESS) {
+            continue;
+        }
+        steps = 0;
+        do {
+            status = cipher_job_step(&job, 1U + pick(len / 4U + 8U));
+            steps++;
+        } while (status == CIPHER_IN_PROGRESS && steps <= 4U * len + 16U);
+        CHECK(status == CIPHER_SUCCESS &&
+              memcmp(work, expect[d], len) == 0,
+              d ? "job_decrypt" : "job_encrypt");
+    }
+    return NULL;
+}
+
+/** Packed output holds table symbols only; other input must be refused. */
+static const char *check_packed(size_t len, int key)
+{
+    cipher_status_t want = expect_status;
+    size_t i;
+
+    for (i = 0; i < len && want == CIPHER_SUCCESS; i++) {
+        if (!cipher_ref_in_table(in[i])) {
+            want = CIPHER_ERROR_INVALID_CHAR;
+        }
+    }
+    CHECK(cipher_encrypt_packed(in, len, key, packed) == want,
+          "encrypt_packed");
+    if (want != CIPHER_SUCCESS) {
+        return NULL;
+    }
+    CHECK(cipher_unpack(packed, len, out) == CIPHER_SUCCESS &&
+          memcmp(out, expect[0], len) == 0, "encrypt_packed");
+    CHECK(cipher_pack(in, len, packed) == CIPHER_SUCCESS, "pack");
+    CHECK(cipher_decrypt_packed(packed, len, key, out) == CIPHER_SUCCESS &&
+          memcmp(out, expect[1], len) == 0, "decrypt_packed");
+    return NULL;
+}
+
+static size_t tx_len;
+
+static void tx_start(void *user, const char *data, size_t len)
+{
+    (void)user;
+    memcpy(out, data, len);
+    tx_len = len;
+}
+
+/** TX ring: what goes on the wire is the reference ciphertext. */
+static const char *check_tx(size_t len, int key)
+{
+    static char   slot_mem[2][CIPHER_MAX_INPUT_LEN];
+    cipher_span_t slots[2];
+    cipher_tx_t   tx;
+    cipher_status_t status;
+
+    slots[0].data = slot_mem[0];
+    slots[1].data = slot_mem[1];
+    status = cipher_tx_init(&tx, slots, 2U, CIPHER_MAX_INPUT_LEN, key,
+                            tx_start, NULL);
+    CHECK(status == (key <= 0 ? CIPHER_ERROR_INVALID_KEY : CIPHER_SUCCESS),
+          "tx_init");
+    if (status != CIPHER_SUCCESS) {
+        return NULL;
+    }
+    tx_len = (size_t)-1;
+    CHECK(cipher_tx_submit(&tx, in, len) == expect_status, "tx_submit");
+    if (expect_status != CIPHER_SUCCESS) {
+        return NULL;
+    }
+    CHECK(tx_len == len && memcmp(out, expect[0], len) == 0, "tx_submit");
+    cipher_tx_complete(&tx);
+    CHECK(cipher_tx_pending(&tx) == 0U, "tx_complete");
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------
+ * Public
+ * ---------------------------------------------------------------------- */
+
+const char *cipher_diff_check(const char *data, size_t len, int key,
+                              uint32_t seed)
+{
+    typedef const char *(*check_fn)(size_t len, int key);
+    static const check_fn check[] = {
+        check_buf, check_to, check_string, check_key64, check_strict, check_key,
+        check_plan, check_frames, check_iov, check_stream, check_job,
+        check_packed, check_tx
+    };
+    const char *fail;
+    size_t i;
+    int d;
+
+    if (len > CIPHER_DIFF_MAX_LEN) {
+        return "cipher_diff_check: input too long";
+    }
+    rng = seed | 1U;                        /* xorshift must not start at 0 */
+    memcpy(in, data, len);
+    in[len] = '\0';
+    for (d = 0; d < 2; d++) {
+        memcpy(expect[d], in, len);
+        expect_status = d ? cipher_ref_decrypt_buf(expect[d], len, key)
+                          : cipher_ref_encrypt_buf(expect[d], len, key);
+    }
+    for (i = 0; i < sizeof(check) / sizeof(check[0]); i++) {
+        fail = check[i](len, key);
+        if (fail != NULL) {
+            return fail;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file cipher_diff.h
+ * @brief Differential check of every library entry point against the
+ *        frozen reference in cipher_ref.h.
+ *
+ * Shared by the randomized test target (tests/test_cipher_diff.c) and the
+ * libFuzzer / AFL harness (fuzz/fuzz_cipher.c). Host only: keeps its
+ * scratch buffers and a plan cache and key handle in static storage, so it
+ * is not reentrant.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#ifndef CIPHER_DIFF_H
+#define CIPHER_DIFF_H
+
+#include "cipher.h"
+
+/** Longest input checked; runs past CIPHER_MAX_INPUT_LEN on purpose. */
+#define CIPHER_DIFF_MAX_LEN (CIPHER_MAX_INPUT_LEN + 64U)
+
+/**
+ * @brief Run `data` through every entry point in both directions and
+ *        compare status and output with the reference.
+ *
+ * Covers the buffer API under each dispatch kernel, _to, strings, the
+ * 64-bit key variants, uppercase, strict, ctx, key handles, plans, the
+ * plan cache, batch, bulk, column, iov, streams, jobs, packed output and
+ * the TX ring. `seed` picks
+ * how the input is split into frames, fragments, chunks and job budgets,
+ * so different seeds exercise different boundaries on the same bytes.
+ *
+ * @param[in] data  Input bytes (any values, NUL included).
+ * @param[in] len   Number of bytes, at most CIPHER_DIFF_MAX_LEN.
+ * @param[in] key   Any key; invalid ones must fail like the reference.
+ * @param[in] seed  Split pattern.
+ * @return NULL if everything matched, otherwise the name of the first
+ *         mismatching check.
+ */
+const char *cipher_diff_check(const char *data, size_t len, int key,
+                              uint32_t seed);
+
+#endif
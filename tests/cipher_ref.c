@@ -0,0 +1,299 @@
+/**
+ * @file cipher_ref.c
+ * @brief Frozen reference implementation of the cipher (test oracle).
+ *
+ * See cipher_ref.h. Deliberately naive; never link into libcipher.a.
+ *
+ * @author Rushikesh Kaduskar
+ */
+
+#include "cipher_ref.h"
+
+#include <string.h>
+
+/* ============= original firmware code: do not edit below ============== */
+
+static const char SUBSTITUTION_TABLE[CIPHER_TABLE_SIZE][2] = {
+    {'0', 'B'}, {'1', ';'}, {'2', 'C'}, {'3', 'D'},
+    {'4', ':'}, {'5', 'F'}, {'6', 'E'}, {'7', '9'},
+    {'8', '3'}, {'9', '8'}, {'A', '2'}, {'B', '4'},
+    {'C', ','}, {'D', '0'}, {'E', '='}, {'F', '1'},
+    {':', 'A'}, {',', '7'}, {'=', '5'}, {';', '6'}
+};
+
+static void shift_left_once(char *str, int len) {
+    int mid = (len - 1) / 2;
+    int j;
+    char temp;
+
+    /* Rotate lower half left by one position */
+    for (j = 0; j < mid; j++) {
+        temp      = str[j + 1];
+        str[j + 1] = str[j];
+        str[j]    = temp;
+    }
+
+    /* Rotate upper half left by one position */
+    for (j = mid + 1; j < len - 1; j++) {
+        temp       = str[j + 1];
+        str[j + 1] = str[j];
+        str[j]     = temp;
+    }
+}
+
+static void shift_right_once(char *str, int len) {
+    int mid = (len - 1) / 2;
+    int j;
+    char temp;
+
+    /* Rotate upper half right by one position */
+    for (j = len - 1; j > mid; j--) {
+        temp       = str[j - 1];
+        str[j - 1] = str[j];
+        str[j]     = temp;
+    }
+
+    /* Rotate lower half right by one position */
+    for (j = mid + 1; j > 0; j--) {
+        temp       = str[j - 1];
+        str[j - 1] = str[j];
+        str[j]     = temp;
+    }
+}
+
+static void substitute_forward(char *str, int len)
+{
+    int i, a;
+    for (i = 0; i < len && str[i] != '\0'; i++) {
+        for (a = 0; a < (int)CIPHER_TABLE_SIZE; a++) {
+            if (SUBSTITUTION_TABLE[a][0] == str[i]) {
+                str[i] = SUBSTITUTION_TABLE[a][1];
+                break;
+            }
+        }
+    }
+}
+
+static void substitute_reverse(char *str, int len)
+{
+    int i, a;
+    for (i = 0; i < len && str[i] != '\0'; i++) {
+        for (a = 0; a < (int)CIPHER_TABLE_SIZE; a++) {
+            if (SUBSTITUTION_TABLE[a][1] == str[i]) {
+                str[i] = SUBSTITUTION_TABLE[a][0];
+                break;
+            }
+        }
+    }
+}
+
+/* ================ end of original code; harness follows ================ */
+
+#define REF_MAX_LEN    (2U * CIPHER_MAX_INPUT_LEN)
+#define REF_LOOP_KEYS  64U      /* keys up to this run the literal loop */
+
+typedef void (*ref_step_fn)(char *str, int len);
+
+static uint16_t perm[REF_MAX_LEN];      /* perm[j]: input offset of byte j */
+static uint16_t power[REF_MAX_LEN];
+static uint16_t scratch_perm[REF_MAX_LEN];
+static char     plane[2][REF_MAX_LEN + 1U];
+static char     copy[REF_MAX_LEN];
+
+/**
+ * Record one step as a permutation: run it on the low and high bytes of
+ * every offset. The step only moves bytes, so each plane moves alike.
+ */
+static void record_step(ref_step_fn step, size_t len)
+{
+    size_t j;
+
+    for (j = 0; j < len; j++) {
+        plane[0][j] = (char)(j & 0xFFU);
+        plane[1][j] = (char)(j >> 8);
+    }
+    plane[0][len] = plane[1][len] = '\0';
+    step(plane[0], (int)len);
+    step(plane[1], (int)len);
+    for (j = 0; j < len; j++) {
+        perm[j] = (uint16_t)((unsigned char)plane[0][j] |
+                             ((unsigned)(unsigned char)plane[1][j] << 8));
+    }
+}
+
+/* a := a o b (apply a, then b), for powers of one permutation */
+static void compose(uint16_t *a, const uint16_t *b, size_t len)
+{
+    size_t j;
+
+    for (j = 0; j < len; j++) {
+        scratch_perm[j] = a[b[j]];
+    }
+    memcpy(a, scratch_perm, len * sizeof(a[0]));
+}
+
+/** buf := buf permuted by perm^key (perm from record_step()). */
+static void ref_shift_power(char *buf, size_t len, uint64_t key)
+{
+    size_t j;
+
+    for (j = 0; j < len; j++) {
+        power[j] = (uint16_t)j;
+    }
+    for (; key != 0U; key >>= 1) {
+        if (key & 1U) {
+            compose(power, perm, len);
+        }
+        compose(perm, perm, len);
+    }
+    memcpy(copy, buf, len);
+    for (j = 0; j < len; j++) {
+        buf[j] = copy[power[j]];
+    }
+}
+
+/** `key` applications of `step` to buf[0 .. len-1]. */
+static void ref_shift(char *buf, size_t len, uint64_t key, ref_step_fn step)
+{
+    if (len < 2U) {
+        return;                     /* the len < 2 quirk, see cipher_ref.h */
+    }
+    if (key <= REF_LOOP_KEYS) {
+        uint64_t i;
+        for (i = 0; i < key; i++) {
+            step(buf, (int)len);
+        }
+        return;
+    }
+    record_step(step, len);
+    ref_shift_power(buf, len, key);
+}
+
+static void ref_transform(char *buf, size_t len, uint64_t key, int decrypt)
+{
+    size_t i;
+
+    if (decrypt) {
+        ref_shift(buf, len, key, shift_right_once);     //Stage 1: Inverse Shift
+        for (i = 0; i < len; i++) {
+            substitute_reverse(buf + i, 1);             //Stage 2: Reverse Substitution
+        }
+    } else {
+        ref_shift(buf, len, key, shift_left_once);      //Stage 1: Shift
+        for (i = 0; i < len; i++) {
+            substitute_forward(buf + i, 1);             //Stage 2: Substitution
+        }
+    }
+}
+
+int cipher_ref_in_table(char c)
+{
+    size_t i;
+
+    for (i = 0; i < CIPHER_TABLE_SIZE; i++) {
+        if (SUBSTITUTION_TABLE[i][0] == c) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void cipher_ref_transform(char *buf, size_t len, int key, int decrypt)
+{
+    ref_transform(buf, len, (uint64_t)key, decrypt);
+}
+
+static cipher_status_t ref_check(const char *buf, size_t len, uint64_t key)
+{
+    if (buf == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    if (key == 0U) {
+        return CIPHER_ERROR_INVALID_KEY;
+    }
+    if (len > CIPHER_MAX_INPUT_LEN) {
+        return CIPHER_ERROR_INVALID_LENGTH;
+    }
+    return CIPHER_SUCCESS;
+}
+
+cipher_status_t cipher_ref_encrypt_buf64(char *buf, size_t len, uint64_t key)
+{
+    cipher_status_t status = ref_check(buf, len, key);
+
+    if (status == CIPHER_SUCCESS) {
+        ref_transform(buf, len, key, 0);
+    }
+    return status;
+}
+
+cipher_status_t cipher_ref_decrypt_buf64(char *buf, size_t len, uint64_t key)
+{
+    cipher_status_t status = ref_check(buf, len, key);
+
+    if (status == CIPHER_SUCCESS) {
+        ref_transform(buf, len, key, 1);
+    }
+    return status;
+}
+
+/* int keys <= 0 are invalid; 0 is the one invalid 64-bit key */
+cipher_status_t cipher_ref_encrypt_buf(char *buf, size_t len, int key)
+{
+    return cipher_ref_encrypt_buf64(buf, len, key > 0 ? (uint64_t)key : 0U);
+}
+
+cipher_status_t cipher_ref_decrypt_buf(char *buf, size_t len, int key)
+{
+    return cipher_ref_decrypt_buf64(buf, len, key > 0 ? (uint64_t)key : 0U);
+}
+
+cipher_status_t cipher_ref_encrypt(char *str, int key)
+{
+    if (str == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    return cipher_ref_encrypt_buf(str, strlen(str), key);
+}
+
+cipher_status_t cipher_ref_decrypt(char *str, int key)
+{
+    if (str == NULL) {
+        return CIPHER_ERROR_NULL_POINTER;
+    }
+    return cipher_ref_decrypt_buf(str, strlen(str), key);
+}
+
+int cipher_ref_self_check(void)
+{
+    static char fast[REF_MAX_LEN];
+    static char slow[REF_MAX_LEN + 1U];
+    static const size_t lens[] = { 2, 3, 4, 7, 64, 257, 1000 };
+    size_t l, j;
+    uint64_t key;
+    int d;
+
+    for (l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+        size_t n = lens[l];
+        for (d = 0; d < 2; d++) {
+            ref_step_fn step = d ? shift_right_once : shift_left_once;
+            for (j = 0; j < n; j++) {
+                slow[j] = (char)('A' + j % 26U);
+            }
+            slow[n] = '\0';
+            /* slow holds `key` literal steps; fast is the squared power */
+            for (key = 1; key <= 4U * REF_LOOP_KEYS; key++) {
+                step(slow, (int)n);
+                for (j = 0; j < n; j++) {
+                    fast[j] = (char)('A' + j % 26U);
+                }
+                record_step(step, n);
+                ref_shift_power(fast, n, key);
+                if (memcmp(fast, slow, n) != 0) {
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
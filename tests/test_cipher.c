@@ -15,7 +15,14 @@
  */
 
 #include "cipher.h"
+#include "cipher_inline.h"
+#include "cipher_job.h"
+#include "cipher_pack.h"
+#include "cipher_plan_cache.h"
+#include "cipher_stream.h"
+#include "cipher_tx.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -152,6 +159,1118 @@ static void test_invalid_key_guard(void)
                 "invalid_key_guard: key=-3 returns CIPHER_ERROR_INVALID_KEY");
 }
 
+/**
+ * Single-step left shift exactly as shipped in the original firmware.
+ * Kept here so the closed-form rotation can be checked against it.
+ */
+static void ref_shift_left_once(char *str, int len)
+{
+    int mid = (len - 1) / 2;
+    int j;
+    char temp;
+
+    for (j = 0; j < mid; j++) {
+        temp       = str[j + 1];
+        str[j + 1] = str[j];
+        str[j]     = temp;
+    }
+    for (j = mid + 1; j < len - 1; j++) {
+        temp       = str[j + 1];
+        str[j + 1] = str[j];
+        str[j]     = temp;
+    }
+}
+
+/**
+ * The shift stage must match `key` single-step shifts byte for byte.
+ * Lowercase letters are outside the substitution table, so the ciphertext
+ * of such a string is the shifted plaintext.
+ */
+static void test_shift_matches_single_step(void)
+{
+    char expect[48];
+    char buf[48];
+    int len, key, i;
+    int mismatches = 0;
+
+    for (len = 0; len < (int)sizeof(buf) - 1; len++) {
+        for (key = 1; key <= 100; key++) {
+            for (i = 0; i < len; i++) {
+                expect[i] = (char)('a' + (i % 26));
+            }
+            expect[len] = '\0';
+            memcpy(buf, expect, (size_t)len + 1U);
+
+            for (i = 0; i < key; i++) {
+                ref_shift_left_once(expect, len);
+            }
+            cipher_encrypt(buf, key);
+            if (memcmp(buf, expect, (size_t)len + 1U) != 0) {
+                mismatches++;
+            }
+        }
+    }
+    TEST_ASSERT(mismatches == 0,
+                "shift_matches_single_step: closed form equals key x single step");
+}
+
+/** Large keys only cost one pass and are reduced per half. */
+static void test_roundtrip_large_key(void)
+{
+    char buf[64];
+    char ref[64];
+    const char *plain = "0123456789ABCDEF:,=;";   /* halves of 10 and 10 */
+
+    strcpy(buf, plain);
+    TEST_ASSERT(cipher_encrypt(buf, INT_MAX) == CIPHER_SUCCESS,
+                "roundtrip_large_key: encrypt(INT_MAX) returns OK");
+    TEST_ASSERT(cipher_decrypt(buf, INT_MAX) == CIPHER_SUCCESS,
+                "roundtrip_large_key: decrypt(INT_MAX) returns OK");
+    TEST_ASSERT(strcmp(buf, plain) == 0,
+                "roundtrip_large_key: recovers original with key=INT_MAX");
+
+    strcpy(buf, plain);
+    strcpy(ref, plain);
+    cipher_encrypt(buf, 3);
+    cipher_encrypt(ref, 3 + 10 * 4000);
+    TEST_ASSERT(strcmp(buf, ref) == 0,
+                "roundtrip_large_key: key is reduced modulo the half length");
+}
+
+/** Buffer API must match the string API and never look past `len`. */
+static void test_buf_api(void)
+{
+    const char *plain = "12:AB,CD=EF;90";
+    size_t len = strlen(plain);
+    char str[32];
+    char buf[32];
+
+    strcpy(str, plain);
+    memcpy(buf, plain, len);
+    buf[len] = 'X';                             /* not terminated */
+
+    cipher_encrypt(str, 7);
+    TEST_ASSERT(cipher_encrypt_buf(buf, len, 7) == CIPHER_SUCCESS,
+                "buf_api: encrypt_buf returns OK");
+    TEST_ASSERT(memcmp(buf, str, len) == 0 && buf[len] == 'X',
+                "buf_api: encrypt_buf matches encrypt and stays within len");
+
+    TEST_ASSERT(cipher_decrypt_buf(buf, len, 7) == CIPHER_SUCCESS,
+                "buf_api: decrypt_buf returns OK");
+    TEST_ASSERT(memcmp(buf, plain, len) == 0 && buf[len] == 'X',
+                "buf_api: decrypt_buf recovers original plaintext");
+}
+
+/** Buffer API argument guards. */
+static void test_buf_guards(void)
+{
+    char buf[4] = { 'A', 'B', 'C', 'D' };
+
+    TEST_ASSERT(cipher_encrypt_buf(NULL, 4, 1) == CIPHER_ERROR_NULL_POINTER,
+                "buf_guards: encrypt_buf(NULL) returns CIPHER_ERROR_NULL_POINTER");
+    TEST_ASSERT(cipher_decrypt_buf(buf, 4, 0) == CIPHER_ERROR_INVALID_KEY,
+                "buf_guards: key=0 returns CIPHER_ERROR_INVALID_KEY");
+    TEST_ASSERT(cipher_encrypt_buf(buf, CIPHER_MAX_INPUT_LEN + 1U, 1)
+                    == CIPHER_ERROR_INVALID_LENGTH,
+                "buf_guards: oversize len returns CIPHER_ERROR_INVALID_LENGTH");
+    TEST_ASSERT(cipher_encrypt_buf(buf, 0, 1) == CIPHER_SUCCESS,
+                "buf_guards: empty buffer is accepted");
+}
+
+/** Over-long strings are still rejected by the string API. */
+static void test_string_too_long(void)
+{
+    static char big[CIPHER_MAX_INPUT_LEN + 2U];
+
+    memset(big, 'A', sizeof(big) - 1U);
+    big[sizeof(big) - 1U] = '\0';
+    TEST_ASSERT(cipher_encrypt(big, 1) == CIPHER_ERROR_INVALID_LENGTH,
+                "string_too_long: returns CIPHER_ERROR_INVALID_LENGTH");
+
+    big[CIPHER_MAX_INPUT_LEN] = '\0';
+    TEST_ASSERT(cipher_encrypt(big, 1) == CIPHER_SUCCESS,
+                "string_too_long: CIPHER_MAX_INPUT_LEN is accepted");
+}
+
+/** Known-answer vector from the README and pass-through of every other byte. */
+static void test_substitution_map(void)
+{
+    const char *alphabet = "0123456789ABCDEF:,=;";
+    char buf[8];
+    int c;
+    int wrong = 0;
+
+    strcpy(buf, "ABCDEF");
+    cipher_encrypt(buf, 1);
+    TEST_ASSERT(strcmp(buf, "4,2=10") == 0,
+                "substitution_map: ABCDEF with key=1 encrypts to 4,2=10");
+
+    for (c = 0; c < 256; c++) {
+        buf[0] = (char)c;
+        cipher_encrypt_buf(buf, 1, 1);
+        if ((c == 0 || strchr(alphabet, c) == NULL) && buf[0] != (char)c) {
+            wrong++;
+        }
+        if (c != 0 && strchr(alphabet, c) != NULL && buf[0] == (char)c) {
+            wrong++;
+        }
+        cipher_decrypt_buf(buf, 1, 1);
+        if (buf[0] != (char)c) {
+            wrong++;
+        }
+    }
+    TEST_ASSERT(wrong == 0,
+                "substitution_map: table bytes map, all other bytes pass through");
+}
+
+/** Out-of-place encrypt/decrypt must match the in-place buffer API. */
+static void test_encrypt_to(void)
+{
+    static const char plain[] = "0123456789ABCDEF:,=;FEDCBA9876543210xyz";
+    char expect[sizeof(plain)];
+    char out[sizeof(plain)];
+    char back[sizeof(plain)];
+    size_t len;
+    int key;
+    int mismatches = 0;
+
+    for (len = 0; len < sizeof(plain); len++) {
+        for (key = 1; key <= 45; key++) {
+            memcpy(expect, plain, len);
+            cipher_encrypt_buf(expect, len, key);
+            cipher_encrypt_to(plain, out, len, key);
+            cipher_decrypt_to(out, back, len, key);
+            if (memcmp(out, expect, len) != 0 || memcmp(back, plain, len) != 0) {
+                mismatches++;
+            }
+        }
+    }
+    TEST_ASSERT(mismatches == 0,
+                "encrypt_to: matches encrypt_buf and decrypt_to inverts it");
+
+    memcpy(out, plain, sizeof(plain));
+    TEST_ASSERT(cipher_encrypt_to(out, out, sizeof(plain) - 1U, 9) == CIPHER_SUCCESS
+                    && cipher_decrypt_to(out, out, sizeof(plain) - 1U, 9) == CIPHER_SUCCESS
+                    && strcmp(out, plain) == 0,
+                "encrypt_to: in == out falls back to in-place");
+
+    TEST_ASSERT(cipher_encrypt_to(plain, NULL, 4, 1) == CIPHER_ERROR_NULL_POINTER,
+                "encrypt_to: NULL output returns CIPHER_ERROR_NULL_POINTER");
+    TEST_ASSERT(cipher_decrypt_to(NULL, out, 4, 1) == CIPHER_ERROR_NULL_POINTER,
+                "encrypt_to: NULL input returns CIPHER_ERROR_NULL_POINTER");
+}
+
+/**
+ * Long buffers take the vector substitution path on hosts that have one;
+ * it must agree with the scalar out-of-place path for every byte value.
+ */
+static void test_long_buffer_all_bytes(void)
+{
+    static char plain[1000];
+    static char inplace[1000];
+    static char outplace[1000];
+    size_t len, i;
+    int mismatches = 0;
+
+    for (i = 0; i < sizeof(plain); i++) {
+        plain[i] = (char)((i * 37U + 11U) & 0xFFU);
+    }
+    for (len = 0; len <= sizeof(plain); len += 37U) {
+        memcpy(inplace, plain, len);
+        cipher_encrypt_buf(inplace, len, 1234);
+        cipher_encrypt_to(plain, outplace, len, 1234);
+        if (memcmp(inplace, outplace, len) != 0) {
+            mismatches++;
+        }
+        cipher_decrypt_buf(inplace, len, 1234);
+        if (memcmp(inplace, plain, len) != 0) {
+            mismatches++;
+        }
+    }
+    TEST_ASSERT(mismatches == 0,
+                "long_buffer_all_bytes: in-place and out-of-place paths agree");
+}
+
+/** Batch API must match per-frame calls and report per-frame status. */
+static void test_batch(void)
+{
+    static const char plain[] = "0123456789ABCDEF:,=;0123456789";
+    char bufs[6][32];
+    char expect[6][32];
+    cipher_span_t frames[6];
+    cipher_status_t status[6];
+    static const size_t lens[6] = { 12, 30, 12, 0, 7, 30 };
+    size_t i;
+    int same = 1;
+
+    for (i = 0; i < 6; i++) {
+        memcpy(bufs[i], plain, lens[i]);
+        memcpy(expect[i], plain, lens[i]);
+        cipher_encrypt_buf(expect[i], lens[i], 77);
+        frames[i].data = bufs[i];
+        frames[i].len  = lens[i];
+    }
+    frames[4].data = NULL;
+
+    TEST_ASSERT(cipher_encrypt_batch(frames, 6, 77, status)
+                    == CIPHER_ERROR_NULL_POINTER,
+                "batch: returns the first frame error");
+    for (i = 0; i < 6; i++) {
+        if (i != 4 && (status[i] != CIPHER_SUCCESS
+                       || memcmp(bufs[i], expect[i], lens[i]) != 0)) {
+            same = 0;
+        }
+    }
+    TEST_ASSERT(same && status[4] == CIPHER_ERROR_NULL_POINTER,
+                "batch: good frames match encrypt_buf, bad frame is flagged");
+
+    TEST_ASSERT(cipher_decrypt_batch(frames, 6, 77, NULL)
+                    == CIPHER_ERROR_NULL_POINTER,
+                "batch: status array is optional");
+    for (i = 0; i < 6; i++) {
+        if (i != 4 && memcmp(bufs[i], plain, lens[i]) != 0) {
+            same = 0;
+        }
+    }
+    TEST_ASSERT(same, "batch: decrypt_batch recovers every frame");
+
+    TEST_ASSERT(cipher_encrypt_batch(NULL, 1, 1, NULL) == CIPHER_ERROR_NULL_POINTER,
+                "batch: NULL frame array returns CIPHER_ERROR_NULL_POINTER");
+    TEST_ASSERT(cipher_encrypt_batch(frames, 2, 0, status) == CIPHER_ERROR_INVALID_KEY
+                    && status[0] == CIPHER_ERROR_INVALID_KEY,
+                "batch: key=0 is reported for every frame");
+}
+
+/** Plan-based gather/scatter must match cipher_encrypt_to(). */
+static void test_plan(void)
+{
+    static const size_t lens[4] = { 1, 64, 128, 512 };
+    static cipher_index_t storage[512];
+    static char plain[512];
+    static char expect[512];
+    static char out[512];
+    static char back[512];
+    cipher_plan_t plan;
+    size_t i, n;
+    int ok = 1;
+
+    for (i = 0; i < sizeof(plain); i++) {
+        plain[i] = "0123456789ABCDEF:,=;"[i % 20U];
+    }
+    for (n = 0; n < 4; n++) {
+        if (cipher_plan_init(&plan, storage, lens[n], 40000) != CIPHER_SUCCESS) {
+            ok = 0;
+            continue;
+        }
+        cipher_encrypt_to(plain, expect, lens[n], 40000);
+        cipher_plan_encrypt(&plan, plain, out);
+        cipher_plan_decrypt(&plan, out, back);
+        if (memcmp(out, expect, lens[n]) != 0 || memcmp(back, plain, lens[n]) != 0) {
+            ok = 0;
+        }
+    }
+    TEST_ASSERT(ok, "plan: gather/scatter match encrypt_to for 1/64/128/512 bytes");
+
+    TEST_ASSERT(cipher_plan_init(&plan, NULL, 64, 1) == CIPHER_ERROR_NULL_POINTER,
+                "plan: NULL storage returns CIPHER_ERROR_NULL_POINTER");
+    TEST_ASSERT(cipher_plan_init(&plan, storage, 64, 0) == CIPHER_ERROR_INVALID_KEY,
+                "plan: key=0 returns CIPHER_ERROR_INVALID_KEY");
+}
+
+/** Stream sink used by the tests: writes each run at its offset. */
+typedef struct {
+    char  *out;
+    size_t written;
+} stream_sink_t;
+
+static void stream_sink(void *user, size_t offset, const char *data, size_t len)
+{
+    stream_sink_t *sink = (stream_sink_t *)user;
+
+    memcpy(sink->out + offset, data, len);
+    sink->written += len;
+}
+
+/** Feed `len` bytes through a stream in uneven fragments. */
+static cipher_status_t stream_run(cipher_stream_t *stream, const char *in,
+                                  size_t len)
+{
+    size_t pos = 0, step = 1;
+    cipher_status_t s = CIPHER_SUCCESS;
+
+    while (pos < len && s == CIPHER_SUCCESS) {
+        size_t n = (len - pos < step) ? len - pos : step;
+        s = cipher_stream_update(stream, in + pos, n);
+        pos += n;
+        step = step * 3U + 1U;
+        if (step > 5000U) {
+            step = 7U;
+        }
+    }
+    return (s == CIPHER_SUCCESS) ? cipher_stream_final(stream) : s;
+}
+
+/** Chunked output must equal the one-shot functions, at any size. */
+static void test_stream(void)
+{
+    static char plain[120000];
+    static char expect[CIPHER_MAX_INPUT_LEN];
+    static char out[120000];
+    static char back[120000];
+    static const size_t lens[5] = { 0, 1, 33, 4097, CIPHER_MAX_INPUT_LEN };
+    cipher_stream_t stream;
+    stream_sink_t sink;
+    size_t i;
+    int ok = 1;
+
+    for (i = 0; i < sizeof(plain); i++) {
+        plain[i] = "0123456789ABCDEF:,=;"[(i * 7U) % 20U];
+    }
+
+    for (i = 0; i < 5; i++) {
+        sink.out = out;
+        sink.written = 0;
+        cipher_encrypt_to(plain, expect, lens[i], 65537);
+        if (cipher_stream_encrypt_init(&stream, lens[i], 65537, stream_sink, &sink)
+                != CIPHER_SUCCESS
+            || stream_run(&stream, plain, lens[i]) != CIPHER_SUCCESS
+            || sink.written != lens[i]
+            || memcmp(out, expect, lens[i]) != 0) {
+            ok = 0;
+        }
+    }
+    TEST_ASSERT(ok, "stream: chunked encrypt matches encrypt_to");
+
+    sink.out = out;
+    sink.written = 0;
+    cipher_stream_encrypt_init(&stream, sizeof(plain), 99991, stream_sink, &sink);
+    ok = stream_run(&stream, plain, sizeof(plain)) == CIPHER_SUCCESS;
+    sink.out = back;
+    sink.written = 0;
+    cipher_stream_decrypt_init(&stream, sizeof(plain), 99991, stream_sink, &sink);
+    ok = ok && stream_run(&stream, out, sizeof(plain)) == CIPHER_SUCCESS;
+    TEST_ASSERT(ok && memcmp(back, plain, sizeof(plain)) == 0
+                   && memcmp(out, plain, sizeof(plain)) != 0,
+                "stream: 120 KB payload round-trips");
+
+    cipher_stream_encrypt_init(&stream, 4, 1, stream_sink, &sink);
+    TEST_ASSERT(cipher_stream_update(&stream, plain, 5) == CIPHER_ERROR_INVALID_LENGTH,
+                "stream: overrunning total_len returns CIPHER_ERROR_INVALID_LENGTH");
+    cipher_stream_update(&stream, plain, 3);
+    TEST_ASSERT(cipher_stream_final(&stream) == CIPHER_ERROR_INVALID_LENGTH,
+                "stream: short payload is reported by final");
+}
+
+/** Fused uppercase + encrypt must equal cipher_to_uppercase() + encrypt. */
+static void test_encrypt_uppercase(void)
+{
+    static char fused[600];
+    static char twopass[600];
+    size_t i;
+    int c;
+    int wrong = 0;
+
+    for (i = 0; i < sizeof(fused) - 1U; i++) {
+        fused[i] = (char)(1 + (i * 29U) % 255U);        /* every non-NUL byte */
+    }
+    fused[sizeof(fused) - 1U] = '\0';
+    memcpy(twopass, fused, sizeof(fused));
+
+    cipher_to_uppercase(twopass);
+    cipher_encrypt(twopass, 321);
+    TEST_ASSERT(cipher_encrypt_uppercase(fused, 321) == CIPHER_SUCCESS
+                    && memcmp(fused, twopass, sizeof(fused)) == 0,
+                "encrypt_uppercase: matches to_uppercase + encrypt");
+
+    for (c = 0; c < 256; c++) {
+        char one = (char)c;
+        char ref = (char)c;
+        cipher_encrypt_uppercase_buf(&one, 1, 1);
+        if (c >= 'a' && c <= 'z') {
+            ref = (char)(c - 'a' + 'A');
+        }
+        cipher_encrypt_buf(&ref, 1, 1);
+        if (one != ref) {
+            wrong++;
+        }
+    }
+    TEST_ASSERT(wrong == 0,
+                "encrypt_uppercase: every byte value folds then substitutes");
+
+    TEST_ASSERT(cipher_encrypt_uppercase(NULL, 1) == CIPHER_ERROR_NULL_POINTER,
+                "encrypt_uppercase: NULL returns CIPHER_ERROR_NULL_POINTER");
+}
+
+/** Header-only constant-key variants must equal the library functions. */
+static void test_inline_fixed(void)
+{
+    static const char plain[] =
+        "0123456789ABCDEF:,=;0123456789ABCDEF:,=;0123456789ABCDEF:,=;xyz";
+    char *volatile none = NULL;     /* runtime NULL: no -Wnonnull on memcpy */
+    cipher_status_t status;
+    char fixed[64];
+    char expect[64];
+    char out[64];
+
+    memcpy(fixed, plain, 64);
+    cipher_encrypt_to(plain, expect, 64, 40503);
+    CIPHER_ENCRYPT_FIXED(fixed, 64, 40503, status);
+    TEST_ASSERT(status == CIPHER_SUCCESS && memcmp(fixed, expect, 64) == 0,
+                "inline_fixed: 64-byte constant encrypt matches encrypt_to");
+
+    CIPHER_DECRYPT_FIXED(fixed, 64, 40503, status);
+    TEST_ASSERT(status == CIPHER_SUCCESS && memcmp(fixed, plain, 64) == 0,
+                "inline_fixed: 64-byte constant decrypt recovers plaintext");
+
+    CIPHER_ENCRYPT_FIXED(fixed, 64, 0, status);
+    TEST_ASSERT(status == CIPHER_ERROR_INVALID_KEY && memcmp(fixed, plain, 64) == 0,
+                "inline_fixed: key=0 reports CIPHER_ERROR_INVALID_KEY, buffer untouched");
+    CIPHER_DECRYPT_FIXED(none, 64, 40503, status);
+    TEST_ASSERT(status == CIPHER_ERROR_NULL_POINTER,
+                "inline_fixed: NULL reports CIPHER_ERROR_NULL_POINTER");
+
+    cipher_encrypt_to(plain, expect, 17, 3);
+    TEST_ASSERT(cipher_encrypt_to_inline(plain, out, 17, 3) == CIPHER_SUCCESS
+                    && memcmp(out, expect, 17) == 0,
+                "inline_fixed: odd length matches encrypt_to");
+    TEST_ASSERT(cipher_encrypt_to_inline(plain, out, 4, 0) == CIPHER_ERROR_INVALID_KEY,
+                "inline_fixed: key=0 returns CIPHER_ERROR_INVALID_KEY");
+}
+
+/* ---- Runtime substitution context -------------------------------------- */
+static void test_ctx(void)
+{
+    static const char builtin[CIPHER_TABLE_SIZE][2] = {
+        {'0', 'B'}, {'1', ';'}, {'2', 'C'}, {'3', 'D'}, {'4', ':'},
+        {'5', 'F'}, {'6', 'E'}, {'7', '9'}, {'8', '3'}, {'9', '8'},
+        {'A', '2'}, {'B', '4'}, {'C', ','}, {'D', '0'}, {'E', '='},
+        {'F', '1'}, {':', 'A'}, {',', '7'}, {'=', '5'}, {';', '6'}
+    };
+    char table[CIPHER_TABLE_SIZE][2];
+    char buf[]    = "0123456789ABCDEF:,=;\xC0\xFFtail";
+    char orig[sizeof buf];
+    char out[sizeof buf];
+    cipher_ctx_t ctx;
+    size_t i;
+
+    TEST_ASSERT(cipher_ctx_init(&ctx, builtin) == CIPHER_SUCCESS,
+                "ctx: built-in table is accepted");
+    TEST_ASSERT(memcmp(ctx.forward, cipher_default_ctx.forward, 256) == 0 &&
+                memcmp(ctx.inverse, cipher_default_ctx.inverse, 256) == 0,
+                "ctx: built-in table reproduces the default maps");
+
+    /* Rotated table over a wider symbol set, including bytes >= 0x80 */
+    for (i = 0; i < CIPHER_TABLE_SIZE; i++) {
+        table[i][0] = (char)(0xC0 + i * 2);
+        table[i][1] = (char)(0xC0 + ((i + 7) % CIPHER_TABLE_SIZE) * 2);
+    }
+    table[0][0] = 't';
+    table[13][1] = 't';
+    TEST_ASSERT(cipher_ctx_init(&ctx, (const char (*)[2])table) == CIPHER_SUCCESS,
+                "ctx: rotated custom table is accepted");
+    memcpy(orig, buf, sizeof buf);
+    cipher_ctx_encrypt_buf(&ctx, buf, sizeof buf - 1, 7);
+    cipher_ctx_encrypt_to(&ctx, orig, out, sizeof buf - 1, 7);
+    TEST_ASSERT(memcmp(buf, out, sizeof buf - 1) == 0,
+                "ctx: encrypt_to matches encrypt_buf under a custom table");
+    cipher_ctx_decrypt_buf(&ctx, buf, sizeof buf - 1, 7);
+    TEST_ASSERT(memcmp(buf, orig, sizeof buf) == 0,
+                "ctx: custom table round-trips");
+
+    memcpy(table, builtin, sizeof table);
+    table[3][0] = '2';
+    TEST_ASSERT(cipher_ctx_init(&ctx, (const char (*)[2])table) == CIPHER_ERROR_INVALID_TABLE,
+                "ctx: repeated plaintext symbol is rejected");
+    memcpy(table, builtin, sizeof table);
+    table[3][1] = 'C';
+    TEST_ASSERT(cipher_ctx_init(&ctx, (const char (*)[2])table) == CIPHER_ERROR_INVALID_TABLE,
+                "ctx: repeated ciphertext symbol is rejected");
+    memcpy(table, builtin, sizeof table);
+    table[3][1] = 'Z';
+    TEST_ASSERT(cipher_ctx_init(&ctx, (const char (*)[2])table) == CIPHER_ERROR_INVALID_TABLE,
+                "ctx: ciphertext symbol outside the plaintext set is rejected");
+    memcpy(table, builtin, sizeof table);
+    table[0][1] = '0';
+    table[13][1] = 'B';
+    TEST_ASSERT(cipher_ctx_init(&ctx, (const char (*)[2])table) == CIPHER_ERROR_INVALID_TABLE,
+                "ctx: symbol mapping to itself is rejected");
+    TEST_ASSERT(cipher_ctx_encrypt_buf(NULL, buf, 4, 1) == CIPHER_ERROR_NULL_POINTER,
+                "ctx: NULL context returns CIPHER_ERROR_NULL_POINTER");
+}
+
+/* ---- Packed wire format ------------------------------------------------- */
+static void test_packed(void)
+{
+    static const char plain[] =
+        "0123456789ABCDEF:,=;FEDCBA9876543210;=,:0123456789ABCDEF:,=;DEAD";
+    char cipher[64];
+    char back[64];
+    unsigned char packed[CIPHER_PACKED_SIZE(64)];
+    unsigned char fused[CIPHER_PACKED_SIZE(64)];
+    size_t len;
+    int ok = 1;
+
+    TEST_ASSERT(CIPHER_PACKED_SIZE(64) == 35U && CIPHER_PACKED_SIZE(1) == 1U &&
+                CIPHER_PACKED_SIZE(2) == 2U && CIPHER_PACKED_SIZE(3) == 2U,
+                "packed: 64 symbols pack into 35 bytes");
+
+    for (len = 0; len <= 64 && ok; len++) {
+        memset(packed, 0xA5, sizeof packed);
+        memset(fused, 0x5A, sizeof fused);
+        cipher_encrypt_to(plain, cipher, len, 40503);
+        ok = cipher_pack(cipher, len, packed) == CIPHER_SUCCESS &&
+             cipher_encrypt_packed(plain, len, 40503, fused) == CIPHER_SUCCESS &&
+             memcmp(packed, fused, CIPHER_PACKED_SIZE(len)) == 0 &&
+             cipher_unpack(packed, len, back) == CIPHER_SUCCESS &&
+             memcmp(back, cipher, len) == 0 &&
+             cipher_decrypt_packed(fused, len, 40503, back) == CIPHER_SUCCESS &&
+             memcmp(back, plain, len) == 0;
+    }
+    TEST_ASSERT(ok, "packed: fused encrypt matches encrypt_to + pack and round-trips");
+
+    TEST_ASSERT(cipher_encrypt_packed("01x3", 4, 1, fused) == CIPHER_ERROR_INVALID_CHAR,
+                "packed: byte outside the alphabet returns CIPHER_ERROR_INVALID_CHAR");
+    memset(packed, 0xFF, 2);
+    TEST_ASSERT(cipher_unpack(packed, 3, back) == CIPHER_ERROR_INVALID_CHAR,
+                "packed: out-of-range group returns CIPHER_ERROR_INVALID_CHAR");
+    TEST_ASSERT(cipher_decrypt_packed(packed, 3, 0, back) == CIPHER_ERROR_INVALID_KEY,
+                "packed: key=0 returns CIPHER_ERROR_INVALID_KEY");
+}
+
+/* ---- Scatter/gather fragments ------------------------------------------ */
+static void test_iov(void)
+{
+    static const char plain[] =
+        "0123456789ABCDEF:,=;FEDCBA9876543210;=,:0123456789ABCDEF:,=;DEADBEEF";
+    char whole[72];
+    char parts[72];
+    cipher_span_t frags[5];
+    size_t len, cut, i;
+    int ok = 1;
+
+    /* Every length, split at three points that sweep the buffer, with an
+     * empty fragment in the middle */
+    for (len = 0; len < sizeof plain && ok; len++) {
+        for (cut = 0; cut <= len && ok; cut++) {
+            memcpy(whole, plain, len);
+            memcpy(parts, plain, len);
+            frags[0].data = parts;             frags[0].len = cut / 2U;
+            frags[1].data = parts + cut / 2U;  frags[1].len = cut - cut / 2U;
+            frags[2].data = parts + cut;       frags[2].len = 0U;
+            frags[3].data = parts + cut;       frags[3].len = (len - cut) / 3U;
+            frags[4].data = frags[3].data + frags[3].len;
+            frags[4].len  = len - cut - frags[3].len;
+
+            cipher_encrypt_buf(whole, len, 40503);
+            ok = cipher_encrypt_iov(frags, 5, 40503) == CIPHER_SUCCESS &&
+                 memcmp(whole, parts, len) == 0;
+        }
+    }
+    TEST_ASSERT(ok, "iov: fragments match encrypt_buf on the concatenation");
+
+    /* Decrypt with a different fragmentation: one byte per fragment */
+    memcpy(whole, plain, 9);
+    cipher_encrypt_buf(whole, 9, 5);
+    for (i = 0; i < 5; i++) {
+        frags[i].data = whole + i * 2U;
+        frags[i].len  = (i < 4) ? 2U : 1U;
+    }
+    TEST_ASSERT(cipher_decrypt_iov(frags, 5, 5) == CIPHER_SUCCESS &&
+                memcmp(whole, plain, 9) == 0,
+                "iov: decrypt with a different fragmentation recovers plaintext");
+
+    frags[2].data = NULL;
+    TEST_ASSERT(cipher_encrypt_iov(frags, 5, 5) == CIPHER_ERROR_NULL_POINTER,
+                "iov: NULL fragment returns CIPHER_ERROR_NULL_POINTER");
+    frags[2].data = whole;
+    frags[2].len  = CIPHER_MAX_INPUT_LEN;
+    TEST_ASSERT(cipher_encrypt_iov(frags, 5, 5) == CIPHER_ERROR_INVALID_LENGTH,
+                "iov: total above CIPHER_MAX_INPUT_LEN returns CIPHER_ERROR_INVALID_LENGTH");
+}
+
+/* ---- Strict mode ------------------------------------------------------- */
+static void test_strict(void)
+{
+    static const char alphabet[] = "0123456789ABCDEF:,=;";
+    char buf[100];
+    char orig[100];
+    char expect[100];
+    size_t bad, i;
+    int ok = 1;
+
+    for (i = 0; i < sizeof buf; i++) {
+        orig[i] = alphabet[(i * 7U) % 20U];
+    }
+    memcpy(buf, orig, sizeof buf);
+    memcpy(expect, orig, sizeof buf);
+    cipher_encrypt_buf(expect, sizeof buf, 40503);
+    TEST_ASSERT(cipher_encrypt_buf_strict(buf, sizeof buf, 40503, &bad) == CIPHER_SUCCESS &&
+                memcmp(buf, expect, sizeof buf) == 0,
+                "strict: valid input matches encrypt_buf");
+    TEST_ASSERT(cipher_decrypt_buf_strict(buf, sizeof buf, 40503, NULL) == CIPHER_SUCCESS &&
+                memcmp(buf, orig, sizeof buf) == 0,
+                "strict: valid ciphertext decrypts");
+
+    /* A bad byte at every offset, behind vector and scalar paths */
+    for (i = 0; i < sizeof buf && ok; i++) {
+        memcpy(buf, orig, sizeof buf);
+        buf[i] = 'x';
+        if (i + 3U < sizeof buf) {
+            buf[i + 3U] = '\n';
+        }
+        memcpy(expect, buf, sizeof buf);
+        bad = sizeof buf;
+        ok = cipher_encrypt_buf_strict(buf, sizeof buf, 7, &bad) == CIPHER_ERROR_INVALID_CHAR &&
+             bad == i && memcmp(buf, expect, sizeof buf) == 0;
+    }
+    TEST_ASSERT(ok, "strict: reports the first bad offset and leaves the buffer unchanged");
+
+    memcpy(buf, orig, sizeof buf);
+    buf[70] = 'A' - 1;
+    TEST_ASSERT(cipher_decrypt_buf_strict(buf, sizeof buf, 7, &bad) == CIPHER_ERROR_INVALID_CHAR &&
+                bad == 70U,
+                "strict: decrypt reports the ciphertext offset");
+    TEST_ASSERT(cipher_encrypt_buf_strict(buf, sizeof buf, 0, &bad) == CIPHER_ERROR_INVALID_KEY,
+                "strict: key=0 returns CIPHER_ERROR_INVALID_KEY");
+}
+
+/* ---- Instrumentation --------------------------------------------------- */
+#if CIPHER_ENABLE_STATS
+static uint32_t fake_cycles;
+
+static uint32_t fake_clock(void)
+{
+    return fake_cycles += 10U;
+}
+#endif
+
+static void test_stats(void)
+{
+    char buf[] = "0123456789ABCDEF";
+    cipher_stats_t st;
+
+    cipher_stats_reset();
+#if CIPHER_ENABLE_STATS
+    cipher_stats_set_clock(fake_clock);
+#endif
+    cipher_encrypt_buf(buf, 16, 3);
+    cipher_decrypt_buf(buf, 16, 3);
+    cipher_encrypt_buf(buf, 16, 0);
+    cipher_stats_snapshot(&st);
+    cipher_stats_set_clock(NULL);
+
+#if CIPHER_ENABLE_STATS
+    TEST_ASSERT(st.calls == 3U && st.errors == 1U && st.bytes == 32U,
+                "stats: counts calls, errors and bytes");
+    TEST_ASSERT(st.shift_cycles == 20U && st.subst_cycles == 20U,
+                "stats: books one clock step per stage");
+#else
+    TEST_ASSERT(st.calls == 0U && st.bytes == 0U && st.shift_cycles == 0U,
+                "stats: snapshot is zero when instrumentation is compiled out");
+#endif
+}
+
+/* ---- Incremental job --------------------------------------------------- */
+static void test_job(void)
+{
+    static const size_t budgets[] = { 1U, 2U, 7U, 64U, 100000U };
+    char buf[CIPHER_MAX_INPUT_LEN];
+    char expect[CIPHER_MAX_INPUT_LEN];
+    cipher_job_t job;
+    cipher_status_t st;
+    size_t len, b, i, steps;
+    int ok = 1;
+
+    for (len = 0; len < 300U && ok; len += 13U) {
+        for (b = 0; b < sizeof budgets / sizeof budgets[0] && ok; b++) {
+            for (i = 0; i < len; i++) {
+                buf[i] = (char)('0' + i % 43U);
+            }
+            memcpy(expect, buf, len);
+            cipher_encrypt_buf(expect, len, 40503);
+
+            cipher_job_encrypt_init(&job, buf, len, 40503);
+            steps = 0U;
+            do {
+                st = cipher_job_step(&job, budgets[b]);
+                steps++;
+            } while (st == CIPHER_IN_PROGRESS && steps <= 4U * len + 2U);
+            ok = st == CIPHER_SUCCESS && memcmp(buf, expect, len) == 0;
+        }
+    }
+    TEST_ASSERT(ok, "job: stepped encrypt matches encrypt_buf for any budget");
+
+    /* A full-size buffer needs many ticks and never more than ~2n ops */
+    memset(buf, 'A', sizeof buf);
+    memcpy(expect, buf, sizeof buf);
+    cipher_encrypt_buf(expect, sizeof buf, 9999);
+    cipher_job_decrypt_init(&job, expect, sizeof buf, 9999);
+    steps = 0U;
+    while (cipher_job_step(&job, 500U) == CIPHER_IN_PROGRESS) {
+        steps++;
+    }
+    TEST_ASSERT(memcmp(expect, buf, sizeof buf) == 0 && steps > 10U &&
+                steps <= 2U * sizeof buf / 500U,
+                "job: 10 KB decrypt completes in bounded steps");
+    TEST_ASSERT(cipher_job_step(&job, 1U) == CIPHER_SUCCESS,
+                "job: finished job keeps returning CIPHER_SUCCESS");
+    TEST_ASSERT(cipher_job_encrypt_init(&job, buf, 4, 0) == CIPHER_ERROR_INVALID_KEY,
+                "job: key=0 returns CIPHER_ERROR_INVALID_KEY");
+}
+
+/* ---- Prepared key handle ----------------------------------------------- */
+static void test_key_handle(void)
+{
+    static const size_t declared[] = { 17U, 64U, 250U };
+    char buf[300];
+    char expect[300];
+    cipher_key_t handle;
+    size_t len, i;
+    int ok = 1;
+
+    TEST_ASSERT(cipher_key_init(&handle, 40503) == CIPHER_SUCCESS &&
+                cipher_key_prepare(&handle, declared, 3) == CIPHER_SUCCESS,
+                "key_handle: init and prepare succeed");
+
+    /* More distinct lengths than slots: learned, evicted and relearned */
+    for (i = 0; i < 3U && ok; i++) {
+        for (len = 0; len < sizeof buf && ok; len += 11U) {
+            memset(buf, 0, sizeof buf);
+            memcpy(buf, "0123456789ABCDEF:,=;0123456789ABCDEF:,=;", 40);
+            memcpy(expect, buf, len);
+            cipher_encrypt_buf(expect, len, 40503);
+            ok = cipher_key_encrypt_buf(&handle, buf, len) == CIPHER_SUCCESS &&
+                 memcmp(buf, expect, len) == 0;
+            cipher_decrypt_buf(expect, len, 40503);
+            ok = ok && cipher_key_decrypt_buf(&handle, buf, len) == CIPHER_SUCCESS &&
+                 memcmp(buf, expect, len) == 0;
+        }
+    }
+    TEST_ASSERT(ok, "key_handle: matches encrypt_buf/decrypt_buf for every length");
+
+    TEST_ASSERT(cipher_key_init(&handle, 0) == CIPHER_ERROR_INVALID_KEY,
+                "key_handle: key=0 returns CIPHER_ERROR_INVALID_KEY");
+    cipher_key_init(&handle, 5);
+    TEST_ASSERT(cipher_key_encrypt_buf(&handle, buf, CIPHER_MAX_INPUT_LEN + 1U)
+                    == CIPHER_ERROR_INVALID_LENGTH,
+                "key_handle: oversize len returns CIPHER_ERROR_INVALID_LENGTH");
+}
+
+/* ---- DMA TX pipeline ---------------------------------------------------- */
+typedef struct {
+    char        wire[8][16];    /* copy taken at start: slots get reused */
+    size_t      len[8];
+    size_t      starts;
+} fake_link_t;
+
+static void fake_link_start(void *user, const char *data, size_t len)
+{
+    fake_link_t *link = (fake_link_t *)user;
+
+    if (link->starts < 8U && len <= sizeof link->wire[0]) {
+        memcpy(link->wire[link->starts], data, len);
+        link->len[link->starts]  = len;
+    }
+    link->starts++;
+}
+
+static void test_tx_pipe(void)
+{
+    static const char *frames[] = { "ABC,0123", "9:;=DEF", "0A1B2C3D4E" };
+    char bufs[2][16];
+    char expect[16];
+    cipher_span_t slots[2] = { { bufs[0], 0 }, { bufs[1], 0 } };
+    fake_link_t link;
+    cipher_tx_t tx;
+    size_t i;
+    int ok = 1;
+
+    memset(&link, 0, sizeof link);
+    TEST_ASSERT(cipher_tx_init(&tx, slots, 2, sizeof bufs[0], 7,
+                               fake_link_start, &link) == CIPHER_SUCCESS,
+                "tx_pipe: init succeeds");
+
+    /* First frame starts the idle link; second queues behind it */
+    TEST_ASSERT(cipher_tx_submit(&tx, frames[0], 8) == CIPHER_SUCCESS &&
+                link.starts == 1U,
+                "tx_pipe: submit to idle link starts a transfer");
+    TEST_ASSERT(cipher_tx_submit(&tx, frames[1], 7) == CIPHER_SUCCESS &&
+                link.starts == 1U && cipher_tx_pending(&tx) == 2U,
+                "tx_pipe: submit while busy only queues");
+    TEST_ASSERT(cipher_tx_submit(&tx, frames[2], 10) == CIPHER_BUSY,
+                "tx_pipe: full ring returns CIPHER_BUSY");
+
+    /* Completion chains the queued frame and frees a slot */
+    cipher_tx_complete(&tx);
+    TEST_ASSERT(link.starts == 2U && cipher_tx_pending(&tx) == 1U,
+                "tx_pipe: completion starts the next queued frame");
+    TEST_ASSERT(cipher_tx_submit(&tx, frames[2], 10) == CIPHER_SUCCESS &&
+                link.starts == 2U,
+                "tx_pipe: freed slot accepts a new frame");
+    cipher_tx_complete(&tx);
+    cipher_tx_complete(&tx);
+    TEST_ASSERT(link.starts == 3U && cipher_tx_pending(&tx) == 0U,
+                "tx_pipe: ring drains and link goes idle");
+
+    for (i = 0; i < 3U; i++) {
+        size_t len = strlen(frames[i]);
+
+        cipher_encrypt_to(frames[i], expect, len, 7);
+        ok = ok && link.len[i] == len && memcmp(link.wire[i], expect, len) == 0;
+    }
+    TEST_ASSERT(ok, "tx_pipe: transfers carry the ciphertext in submit order");
+
+    /* Idle again: the next submit restarts the link itself */
+    TEST_ASSERT(cipher_tx_submit(&tx, frames[0], 8) == CIPHER_SUCCESS &&
+                link.starts == 4U,
+                "tx_pipe: submit after drain restarts the link");
+
+    TEST_ASSERT(cipher_tx_submit(&tx, frames[0], 17) == CIPHER_ERROR_INVALID_LENGTH,
+                "tx_pipe: frame larger than a slot returns CIPHER_ERROR_INVALID_LENGTH");
+    TEST_ASSERT(cipher_tx_init(&tx, slots, 3, sizeof bufs[0], 7,
+                               fake_link_start, &link) == CIPHER_ERROR_INVALID_LENGTH,
+                "tx_pipe: non power-of-two slot count is rejected");
+}
+
+/* ---- Kernel autotuning ------------------------------------------------- */
+static uint32_t tune_ticks;
+
+static uint32_t tick_clock(void)
+{
+    return tune_ticks += 3U;
+}
+
+static void test_autotune(void)
+{
+    static char scratch[CIPHER_MAX_INPUT_LEN];
+    char buf[600];
+    char expect[600];
+    cipher_tune_t tuned;
+    cipher_tune_t forced;
+    size_t b, len;
+    unsigned kernel;
+    int ok = 1;
+
+    TEST_ASSERT(cipher_autotune(tick_clock, scratch, sizeof scratch, &tuned) == CIPHER_SUCCESS,
+                "autotune: succeeds");
+    for (b = 0; b < CIPHER_TUNE_BUCKETS; b++) {
+        ok = ok && tuned.kernel[b] < CIPHER_KERNEL_COUNT;
+    }
+    TEST_ASSERT(ok, "autotune: every bucket names a kernel");
+
+    /* Every kernel this build accepts gives the same ciphertext */
+    for (kernel = 0; kernel < CIPHER_KERNEL_COUNT; kernel++) {
+        memset(forced.kernel, (int)kernel, sizeof forced.kernel);
+        if (cipher_tune_use(&forced) != CIPHER_SUCCESS) {
+            continue;
+        }
+        for (len = 0; len < sizeof buf; len += 37U) {
+            memset(buf, 'x', sizeof buf);
+            memcpy(buf, "0123456789ABCDEF:,=;0123456789ABCDEF:,=;", 40);
+            cipher_encrypt_to(buf, expect, len, 40503);
+            cipher_encrypt_buf(buf, len, 40503);
+            ok = ok && memcmp(buf, expect, len) == 0;
+            cipher_decrypt_to(buf, expect, len, 40503);
+            cipher_decrypt_buf(buf, len, 40503);
+            ok = ok && memcmp(buf, expect, len) == 0;
+        }
+    }
+    TEST_ASSERT(ok, "autotune: all kernels match the out-of-place path");
+
+    forced.kernel[3] = (unsigned char)CIPHER_KERNEL_COUNT;
+    TEST_ASSERT(cipher_tune_use(&forced) == CIPHER_ERROR_INVALID_TABLE,
+                "autotune: unknown kernel returns CIPHER_ERROR_INVALID_TABLE");
+    TEST_ASSERT(cipher_autotune(tick_clock, scratch, 0, &tuned) == CIPHER_ERROR_INVALID_LENGTH,
+                "autotune: empty scratch returns CIPHER_ERROR_INVALID_LENGTH");
+    TEST_ASSERT(cipher_tune_use(NULL) == CIPHER_SUCCESS,
+                "autotune: NULL restores the built-in table");
+}
+
+/* ---- Flat bulk API ----------------------------------------------------- */
+static void test_bulk(void)
+{
+    static const char blob[] = "0123456789ABCDEF" ":,=;" "FEDCBA9876543210xyz";
+    const size_t offsets[] = { 0U, 16U, 16U, 20U, 39U };
+    char enc[sizeof blob];
+    char dec[sizeof blob];
+    char expect[sizeof blob];
+    cipher_status_t status[4];
+    size_t bad_offsets[3] = { 0U, 8U, 4U };
+    size_t i;
+    int ok = 1;
+
+    TEST_ASSERT(cipher_encrypt_bulk(blob, offsets, 4, enc, 40503, status) == CIPHER_SUCCESS,
+                "bulk: encrypt succeeds");
+    for (i = 0; i < 4U; i++) {
+        size_t len = offsets[i + 1U] - offsets[i];
+
+        cipher_encrypt_to(blob + offsets[i], expect, len, 40503);
+        ok = ok && status[i] == CIPHER_SUCCESS &&
+             memcmp(enc + offsets[i], expect, len) == 0;
+    }
+    TEST_ASSERT(ok, "bulk: each frame matches cipher_encrypt_to()");
+
+    TEST_ASSERT(cipher_decrypt_bulk(enc, offsets, 4, dec, 40503, NULL) == CIPHER_SUCCESS &&
+                memcmp(dec, blob, 39) == 0,
+                "bulk: decrypt restores the blob");
+    TEST_ASSERT(cipher_decrypt_bulk(enc, offsets, 4, enc, 40503, NULL) == CIPHER_SUCCESS &&
+                memcmp(enc, blob, 39) == 0,
+                "bulk: in place (out == in) restores the blob");
+
+    memset(dec, '#', sizeof dec);
+    TEST_ASSERT(cipher_encrypt_bulk(blob, bad_offsets, 2, dec, 7, status) == CIPHER_ERROR_INVALID_LENGTH &&
+                status[0] == CIPHER_SUCCESS && status[1] == CIPHER_ERROR_INVALID_LENGTH &&
+                dec[8] == '#',
+                "bulk: decreasing offsets fail that frame only");
+    TEST_ASSERT(cipher_encrypt_bulk(blob, NULL, 1, dec, 7, NULL) == CIPHER_ERROR_NULL_POINTER,
+                "bulk: NULL offsets returns CIPHER_ERROR_NULL_POINTER");
+}
+
+/* ---- Arrow string column ---------------------------------------------- */
+static void test_column(void)
+{
+    static const char values[] = "----0123456789ABCDEF" ":,=;" "FEDCBA9876543210";
+    const int32_t offsets[] = { 4, 20, 20, 24, 40 };    /* sliced: starts at 4 */
+    const int32_t bad[] = { 0, -4, 8 };
+    char enc[sizeof values];
+    char dec[sizeof values];
+    char expect[sizeof values];
+    cipher_status_t status[4];
+    size_t i;
+    int ok = 1;
+
+    memcpy(enc, values, sizeof values);
+    TEST_ASSERT(cipher_encrypt_column(values, offsets, 4, enc, 40503, NULL) == CIPHER_SUCCESS &&
+                memcmp(enc, "----", 4) == 0,
+                "column: encrypt succeeds and leaves bytes before offsets[0]");
+    for (i = 0; i < 4U; i++) {
+        size_t len = (size_t)(offsets[i + 1U] - offsets[i]);
+
+        cipher_encrypt_to(values + offsets[i], expect, len, 40503);
+        ok = ok && memcmp(enc + offsets[i], expect, len) == 0;
+    }
+    TEST_ASSERT(ok, "column: each slot matches cipher_encrypt_to()");
+
+    TEST_ASSERT(cipher_decrypt_column(enc, offsets, 4, dec, 40503, status) == CIPHER_SUCCESS &&
+                status[1] == CIPHER_SUCCESS &&
+                memcmp(dec + 4, values + 4, 36) == 0,
+                "column: decrypt restores every slot, empty slots included");
+    TEST_ASSERT(cipher_decrypt_column(enc, bad, 2, dec, 7, status) == CIPHER_ERROR_INVALID_LENGTH &&
+                status[0] == CIPHER_ERROR_INVALID_LENGTH &&
+                status[1] == CIPHER_ERROR_INVALID_LENGTH,
+                "column: negative offsets fail their slots");
+    TEST_ASSERT(cipher_decrypt_column(enc, NULL, 1, dec, 7, NULL) == CIPHER_ERROR_NULL_POINTER,
+                "column: NULL offsets returns CIPHER_ERROR_NULL_POINTER");
+}
+
+/* ---- Plan cache --------------------------------------------------------- */
+static void test_plan_cache(void)
+{
+    static const size_t lens[] = { 40U, 17U, 40U, 64U, 17U, 90U, 40U, 3U, 64U, 0U };
+    cipher_index_t arena[160];
+    cipher_plan_cache_t cache;
+    cipher_plan_cache_stats_t st;
+    const cipher_plan_t *plan;
+    char src[200];
+    char out[200];
+    char expect[200];
+    size_t i;
+    int ok = 1;
+
+    for (i = 0; i < sizeof src; i++) {
+        src[i] = "0123456789ABCDEF:,=;"[(i * 3U) % 20U];
+    }
+    TEST_ASSERT(cipher_plan_cache_init(&cache, arena, 160) == CIPHER_SUCCESS,
+                "plan_cache: init succeeds");
+
+    /* 160 entries: 90 evicts 40 then 64 (least recently used), and the
+     * second 64 evicts 17 then 90 */
+    for (i = 0; i < sizeof lens / sizeof lens[0]; i++) {
+        cipher_encrypt_to(src, expect, lens[i], 777);
+        ok = ok && cipher_plan_cache_encrypt(&cache, src, out, lens[i], 777) == CIPHER_SUCCESS &&
+             memcmp(out, expect, lens[i]) == 0;
+        cipher_decrypt_to(src, expect, lens[i], 777);
+        ok = ok && cipher_plan_cache_decrypt(&cache, src, out, lens[i], 777) == CIPHER_SUCCESS &&
+             memcmp(out, expect, lens[i]) == 0;
+    }
+    TEST_ASSERT(ok, "plan_cache: matches cipher_encrypt_to/decrypt_to across evictions");
+
+    cipher_plan_cache_stats(&cache, &st);
+    TEST_ASSERT(st.hits == 12U && st.misses == 8U && st.evictions == 4U,
+                "plan_cache: counts hits, misses and evictions");
+
+    TEST_ASSERT(cipher_plan_cache_get(&cache, 64U, 778, &plan) == CIPHER_SUCCESS &&
+                plan->len == 64U && plan->key == 778,
+                "plan_cache: same length, other key is a separate plan");
+    TEST_ASSERT(cipher_plan_cache_get(&cache, 161U, 777, &plan) == CIPHER_ERROR_INVALID_LENGTH,
+                "plan_cache: plan larger than the arena returns CIPHER_ERROR_INVALID_LENGTH");
+    cipher_encrypt_to(src, expect, 180, 777);
+    TEST_ASSERT(cipher_plan_cache_encrypt(&cache, src, out, 180, 777) == CIPHER_SUCCESS &&
+                memcmp(out, expect, 180) == 0,
+                "plan_cache: oversize frame falls back to cipher_encrypt_to()");
+    TEST_ASSERT(cipher_plan_cache_get(&cache, 8U, 0, &plan) == CIPHER_ERROR_INVALID_KEY,
+                "plan_cache: key=0 returns CIPHER_ERROR_INVALID_KEY");
+}
+
+/**
+ * 64-bit keys: same output as the int API where both apply, and wide keys
+ * act as their residues modulo each half (41 bytes: halves of 21 and 20,
+ * so a key and its value modulo lcm(21, 20) = 420 must agree).
+ */
+static void test_key64(void)
+{
+    static const uint64_t wide[] = {
+        UINT64_MAX, 0x123456789ABCDEF0ULL, 0x100000000ULL, 0xFFFFFFFFULL
+    };
+    const char *plain = "0123456789ABCDEF:,=;0123456789ABCDEF:,=;Z";  /* 41 */
+    size_t len = strlen(plain);
+    char buf[64];
+    char ref[64];
+    int key, same = 1;
+    size_t i;
+
+    for (key = 1; key <= 500; key += 7) {
+        memcpy(buf, plain, len);
+        memcpy(ref, plain, len);
+        cipher_encrypt_buf64(buf, len, (uint64_t)key);
+        cipher_encrypt_buf(ref, len, key);
+        same = same && memcmp(buf, ref, len) == 0;
+    }
+    strcpy(buf, plain);
+    strcpy(ref, plain);
+    cipher_encrypt64(buf, (uint64_t)INT_MAX);
+    cipher_encrypt(ref, INT_MAX);
+    TEST_ASSERT(same && strcmp(buf, ref) == 0,
+                "key64: keys up to INT_MAX match the int API");
+
+    same = 1;
+    for (i = 0; i < sizeof(wide) / sizeof(wide[0]); i++) {
+        int residue = (int)(wide[i] % 420U);
+
+        memcpy(buf, plain, len);
+        memcpy(ref, plain, len);
+        cipher_encrypt_buf64(buf, len, wide[i]);
+        cipher_encrypt_buf(ref, len, residue != 0 ? residue : 420);
+        same = same && memcmp(buf, ref, len) == 0;
+        cipher_decrypt_to64(buf, ref, len, wide[i]);
+        same = same && memcmp(ref, plain, len) == 0;
+    }
+    TEST_ASSERT(same, "key64: wide keys reduce per half and round-trip");
+
+    strcpy(buf, plain);
+    TEST_ASSERT(cipher_encrypt_to64(plain, buf, len, UINT64_MAX) == CIPHER_SUCCESS &&
+                cipher_decrypt64(buf, UINT64_MAX) == CIPHER_SUCCESS &&
+                strcmp(buf, plain) == 0,
+                "key64: string and _to variants round-trip with UINT64_MAX");
+    TEST_ASSERT(cipher_encrypt_buf64(buf, len, 0U) == CIPHER_ERROR_INVALID_KEY,
+                "key64: key=0 returns CIPHER_ERROR_INVALID_KEY");
+    TEST_ASSERT(cipher_encrypt64(NULL, 1U) == CIPHER_ERROR_NULL_POINTER,
+                "key64: NULL returns CIPHER_ERROR_NULL_POINTER");
+    TEST_ASSERT(cipher_decrypt_buf64(buf, CIPHER_MAX_INPUT_LEN + 1U, 1U) ==
+                    CIPHER_ERROR_INVALID_LENGTH,
+                "key64: oversize len returns CIPHER_ERROR_INVALID_LENGTH");
+}
+
 /* -------------------------------------------------------------------------
  * Main
  * ---------------------------------------------------------------------- */
@@ -167,6 +1286,32 @@ int main(void)
     test_to_upper();
     test_null_ptr_guard();
     test_invalid_key_guard();
+    test_shift_matches_single_step();
+    test_roundtrip_large_key();
+    test_buf_api();
+    test_buf_guards();
+    test_string_too_long();
+    test_substitution_map();
+    test_encrypt_to();
+    test_long_buffer_all_bytes();
+    test_batch();
+    test_plan();
+    test_stream();
+    test_encrypt_uppercase();
+    test_inline_fixed();
+    test_ctx();
+    test_packed();
+    test_iov();
+    test_strict();
+    test_stats();
+    test_job();
+    test_key_handle();
+    test_tx_pipe();
+    test_autotune();
+    test_bulk();
+    test_column();
+    test_plan_cache();
+    test_key64();
 
     printf("\n--- Results: %d/%d passed ---\n\n",
            tests_run - tests_failed, tests_run);
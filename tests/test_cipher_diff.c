@@ -0,0 +1,233 @@
+/**
+ * @file test_cipher_diff.c
+ * @brief Randomized differential tests: every entry point against the
+ *        frozen reference (cipher_ref.c).
+ *
+ * Build and run (from repo root):
+ *   make test
+ *
+ * A longer soak with another seed:
+ *   ./build/test_cipher_diff <iterations> <seed>
+ *
+ * Exit code 0 = all tests passed.
+ * Exit code 1 = one or more tests failed.
+ *
+ * @author Rushikesh Kaduskar
+ */
+
+#include "cipher.h"
+#include "cipher_diff.h"
+#include "cipher_ref.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* -------------------------------------------------------------------------
+ * Minimal test framework (no external dependencies)
+ * ---------------------------------------------------------------------- */
+
+static int tests_run    = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(condition, message)          \
+    do {                                         \
+        tests_run++;                             \
+        if (!(condition)) {                      \
+            tests_failed++;                      \
+            printf("[FAIL] %s\n"                 \
+                   "       %s:%d — %s\n",        \
+                   message, __FILE__, __LINE__,  \
+                   #condition);                  \
+        } else {                                 \
+            printf("[PASS] %s\n", message);      \
+        }                                        \
+    } while (0)
+
+/* -------------------------------------------------------------------------
+ * Fixtures
+ * ---------------------------------------------------------------------- */
+
+static const char symbols[] = "0123456789ABCDEF:,=;";
+
+static char     data[CIPHER_DIFF_MAX_LEN];
+static uint32_t rng = 0x2545F491U;
+
+static uint32_t next(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/**
+ * Input of one of three kinds: table symbols only (strict and packed
+ * succeed), printable ASCII with lowercase (pass-through and case
+ * folding), or arbitrary bytes including NUL.
+ */
+static void fill(size_t len)
+{
+    unsigned kind = next() % 3U;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        uint32_t r = next();
+        if (kind == 0U) {
+            data[i] = symbols[r % (sizeof(symbols) - 1U)];
+        } else if (kind == 1U) {
+            data[i] = (char)(' ' + r % 95U);
+        } else {
+            data[i] = (char)(r & 0xFFU);
+        }
+    }
+}
+
+/** Run one case; report the first few failures in full. */
+static int diff_case(size_t len, int key)
+{
+    static int reported = 0;
+    uint32_t seed = next();
+    const char *fail;
+
+    fill(len);
+    fail = cipher_diff_check(data, len, key, seed);
+    if (fail != NULL && reported < 5) {
+        reported++;
+        printf("       mismatch in %s: len=%lu key=%d seed=0x%08lX\n",
+               fail, (unsigned long)len, key, (unsigned long)seed);
+    }
+    return fail != NULL;
+}
+
+/* -------------------------------------------------------------------------
+ * Tests
+ * ---------------------------------------------------------------------- */
+
+/** The squared-power shortcut must equal the literal `key`-step loop. */
+static void test_diff_reference(void)
+{
+    TEST_ASSERT(cipher_ref_self_check(),
+                "diff_reference: large-key shortcut equals the literal loop");
+}
+
+/**
+ * The original decrypt moved a lone character past its terminator for odd
+ * keys; the library (and the reference) leave it in place, then
+ * substitute it.
+ */
+static void test_diff_one_byte(void)
+{
+    char lib[2] = "B";
+    char ref[2] = "B";
+
+    TEST_ASSERT(cipher_decrypt(lib, 1) == CIPHER_SUCCESS &&
+                cipher_ref_decrypt(ref, 1) == CIPHER_SUCCESS &&
+                lib[0] == '0' && lib[1] == '\0' && ref[0] == '0',
+                "diff_one_byte: 1-char decrypt keeps the char (len < 2 quirk)");
+}
+
+/** Every short length against small keys, where off-by-ones live. */
+static void test_diff_short(void)
+{
+    int mismatches = 0;
+    size_t len;
+    int key;
+
+    for (len = 0; len <= 40U; len++) {
+        for (key = 1; key <= 2 * (int)len + 2; key++) {
+            mismatches += diff_case(len, key);
+        }
+    }
+    TEST_ASSERT(mismatches == 0,
+                "diff_short: lengths 0..40, keys 1..2*len+2 match the reference");
+}
+
+/** Lengths around the limit: everything above it must fail cleanly. */
+static void test_diff_limit(void)
+{
+    static const int keys[] = { 1, 4999, 5000, 5001, INT_MAX };
+    int mismatches = 0;
+    size_t len, k;
+
+    for (len = CIPHER_MAX_INPUT_LEN - 2U; len <= CIPHER_MAX_INPUT_LEN + 3U;
+         len++) {
+        for (k = 0; k < sizeof(keys) / sizeof(keys[0]); k++) {
+            mismatches += diff_case(len, keys[k]);
+        }
+    }
+    mismatches += diff_case(CIPHER_DIFF_MAX_LEN, INT_MAX);
+    TEST_ASSERT(mismatches == 0,
+                "diff_limit: lengths around CIPHER_MAX_INPUT_LEN match the reference");
+}
+
+/** Keys that are not > 0 must be refused everywhere. */
+static void test_diff_bad_keys(void)
+{
+    static const int keys[] = { 0, -1, INT_MIN };
+    int mismatches = 0;
+    size_t k;
+
+    for (k = 0; k < sizeof(keys) / sizeof(keys[0]); k++) {
+        mismatches += diff_case(0U, keys[k]);
+        mismatches += diff_case(17U, keys[k]);
+        mismatches += diff_case(CIPHER_MAX_INPUT_LEN + 1U, keys[k]);
+    }
+    TEST_ASSERT(mismatches == 0,
+                "diff_bad_keys: keys <= 0 fail like the reference");
+}
+
+/**
+ * Random cases: log-uniform lengths up to CIPHER_DIFF_MAX_LEN (most are
+ * short, some cross the limit) and keys up to INT_MAX.
+ */
+static void test_diff_random(unsigned long iterations)
+{
+    int mismatches = 0;
+    unsigned long i;
+
+    for (i = 0; i < iterations; i++) {
+        size_t len = (size_t)(next() % (1UL << (next() % 15U)));
+        int key = (int)(next() & 0x7FFFFFFFU);
+
+        if (len > CIPHER_DIFF_MAX_LEN) {
+            len = CIPHER_DIFF_MAX_LEN;
+        }
+        if (key == 0) {
+            key = 1;
+        }
+        mismatches += diff_case(len, key);
+    }
+    TEST_ASSERT(mismatches == 0,
+                "diff_random: random lengths and keys match the reference");
+}
+
+/* -------------------------------------------------------------------------
+ * Main
+ * ---------------------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+    unsigned long iterations = 2000UL;
+
+    if (argc > 1) {
+        iterations = strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2) {
+        rng = (uint32_t)strtoul(argv[2], NULL, 0) | 1U;
+    }
+
+    printf("\n=== Embedded Cipher Library — Differential Tests ===\n\n");
+
+    test_diff_reference();
+    test_diff_one_byte();
+    test_diff_short();
+    test_diff_limit();
+    test_diff_bad_keys();
+    test_diff_random(iterations);
+
+    printf("\n--- Results: %d/%d passed ---\n\n",
+           tests_run - tests_failed, tests_run);
+
+    return (tests_failed > 0) ? 1 : 0;
+}
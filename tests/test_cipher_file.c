@@ -0,0 +1,245 @@
+/**
+ * @file test_cipher_file.c
+ * @brief Unit tests for the memory-mapped archive API (host only).
+ *
+ * Build and run (from repo root):
+ *   make test
+ *
+ * Exit code 0 = all tests passed.
+ * Exit code 1 = one or more tests failed.
+ *
+ * @author Rushikesh Kaduskar
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "cipher.h"
+#include "cipher_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* -------------------------------------------------------------------------
+ * Minimal test framework (no external dependencies)
+ * ---------------------------------------------------------------------- */
+
+static int tests_run    = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(condition, message)          \
+    do {                                         \
+        tests_run++;                             \
+        if (!(condition)) {                      \
+            tests_failed++;                      \
+            printf("[FAIL] %s\n"                 \
+                   "       %s:%d — %s\n",        \
+                   message, __FILE__, __LINE__,  \
+                   #condition);                  \
+        } else {                                 \
+            printf("[PASS] %s\n", message);      \
+        }                                        \
+    } while (0)
+
+/* -------------------------------------------------------------------------
+ * Fixtures
+ * ---------------------------------------------------------------------- */
+
+#define KEY 40503
+
+static const char *const LINES[] = {
+    "0123456789ABCDEF", "", "DEAD:BEEF", "A", ",=;:,=;:", "FEDCBA9876543210FF"
+};
+#define NLINES (sizeof LINES / sizeof LINES[0])
+
+static char archive[256];
+static char expect[256];
+static char work[256];
+
+/** Newline archive of LINES (last one unterminated) and its ciphertext. */
+static size_t build_newline(void)
+{
+    size_t i, len, pos = 0;
+
+    for (i = 0; i < NLINES; i++) {
+        len = strlen(LINES[i]);
+        memcpy(archive + pos, LINES[i], len);
+        memcpy(expect + pos, LINES[i], len);
+        cipher_encrypt_buf(expect + pos, len, KEY);
+        pos += len;
+        if (i + 1U < NLINES) {
+            archive[pos] = expect[pos] = '\n';
+            pos++;
+        }
+    }
+    return pos;
+}
+
+/** Length-prefixed archive of LINES and its ciphertext. */
+static size_t build_len16(void)
+{
+    size_t i, len, pos = 0;
+
+    for (i = 0; i < NLINES; i++) {
+        len = strlen(LINES[i]);
+        archive[pos]     = expect[pos]     = (char)(len & 0xFFU);
+        archive[pos + 1] = expect[pos + 1] = (char)(len >> 8);
+        pos += 2;
+        memcpy(archive + pos, LINES[i], len);
+        memcpy(expect + pos, LINES[i], len);
+        cipher_encrypt_buf(expect + pos, len, KEY);
+        pos += len;
+    }
+    return pos;
+}
+
+static int write_file(const char *path, const char *data, size_t len)
+{
+    FILE *f = fopen(path, "wb");
+    int ok;
+
+    if (f == NULL) {
+        return 0;
+    }
+    ok = fwrite(data, 1, len, f) == len;
+    return fclose(f) == 0 && ok;
+}
+
+static size_t read_file(const char *path, char *data, size_t cap)
+{
+    FILE *f = fopen(path, "rb");
+    size_t len;
+
+    if (f == NULL) {
+        return (size_t)-1;
+    }
+    len = fread(data, 1, cap, f);
+    fclose(f);
+    return len;
+}
+
+/* -------------------------------------------------------------------------
+ * Tests
+ * ---------------------------------------------------------------------- */
+
+/* ---- In-memory record passes ------------------------------------------ */
+static void test_records(void)
+{
+    cipher_records_report_t report;
+    size_t size;
+
+    size = build_newline();
+    TEST_ASSERT(cipher_records_encrypt(archive, work, size, KEY,
+                                       CIPHER_RECORDS_NEWLINE, &report)
+                    == CIPHER_SUCCESS
+                    && report.records == NLINES && report.failed == 0U
+                    && memcmp(work, expect, size) == 0,
+                "records: newline records match per-record encrypt_buf");
+    TEST_ASSERT(cipher_records_decrypt(work, work, size, KEY,
+                                       CIPHER_RECORDS_NEWLINE, NULL)
+                    == CIPHER_SUCCESS && memcmp(work, archive, size) == 0,
+                "records: in-place newline decrypt recovers the archive");
+
+    size = build_len16();
+    TEST_ASSERT(cipher_records_encrypt(archive, work, size, KEY,
+                                       CIPHER_RECORDS_LEN16, &report)
+                    == CIPHER_SUCCESS
+                    && report.records == NLINES && memcmp(work, expect, size) == 0,
+                "records: length-prefixed records match per-record encrypt_buf");
+
+    /* Drop the last 3 bytes: the final record is torn */
+    TEST_ASSERT(cipher_records_encrypt(archive, work, size - 3U, KEY,
+                                       CIPHER_RECORDS_LEN16, &report)
+                    == CIPHER_ERROR_INVALID_LENGTH
+                    && report.failed == 1U
+                    && report.first_failed == size - 18U
+                    && memcmp(work, expect, size - 20U) == 0
+                    && memcmp(work + size - 18U, archive + size - 18U, 15) == 0,
+                "records: torn record is reported and kept unchanged");
+    TEST_ASSERT(cipher_records_encrypt(archive, work, size, 0,
+                                       CIPHER_RECORDS_LEN16, NULL)
+                    == CIPHER_ERROR_INVALID_KEY,
+                "records: key=0 returns CIPHER_ERROR_INVALID_KEY");
+}
+
+/* ---- Mapped files ------------------------------------------------------ */
+static void test_files(void)
+{
+    char in_path[]  = "/tmp/cipher_file_inXXXXXX";
+    char out_path[] = "/tmp/cipher_file_outXXXXXX";
+    cipher_records_report_t report;
+    size_t size;
+    int fd_in, fd_out;
+
+    fd_in  = mkstemp(in_path);
+    fd_out = mkstemp(out_path);
+    TEST_ASSERT(fd_in >= 0 && fd_out >= 0, "files: temporary files created");
+    if (fd_in < 0 || fd_out < 0) {
+        return;
+    }
+    close(fd_in);
+    close(fd_out);
+
+    size = build_newline();
+    write_file(in_path, archive, size);
+    TEST_ASSERT(cipher_file_encrypt(in_path, out_path, KEY,
+                                    CIPHER_RECORDS_NEWLINE, &report)
+                    == CIPHER_SUCCESS
+                    && read_file(out_path, work, sizeof work) == size
+                    && memcmp(work, expect, size) == 0,
+                "files: encrypt into an output mapping");
+    TEST_ASSERT(cipher_file_decrypt(out_path, NULL, KEY,
+                                    CIPHER_RECORDS_NEWLINE, &report)
+                    == CIPHER_SUCCESS
+                    && read_file(out_path, work, sizeof work) == size
+                    && memcmp(work, archive, size) == 0,
+                "files: in-place decrypt rewrites the mapping");
+
+    write_file(in_path, archive, size);
+    TEST_ASSERT(cipher_file_encrypt(in_path, in_path, KEY,
+                                    CIPHER_RECORDS_NEWLINE, &report)
+                    == CIPHER_SUCCESS
+                    && read_file(in_path, work, sizeof work) == size
+                    && memcmp(work, expect, size) == 0,
+                "files: OUT == IN rewrites in place instead of truncating");
+    unlink(out_path);
+    TEST_ASSERT(link(in_path, out_path) == 0
+                    && cipher_file_decrypt(in_path, out_path, KEY,
+                                           CIPHER_RECORDS_NEWLINE, &report)
+                    == CIPHER_SUCCESS
+                    && read_file(in_path, work, sizeof work) == size
+                    && memcmp(work, archive, size) == 0,
+                "files: OUT linked to IN rewrites in place");
+    unlink(out_path);
+
+    write_file(in_path, archive, 0U);
+    TEST_ASSERT(cipher_file_decrypt(in_path, out_path, KEY,
+                                    CIPHER_RECORDS_NEWLINE, &report)
+                    == CIPHER_SUCCESS && report.records == 0U
+                    && read_file(out_path, work, sizeof work) == 0U,
+                "files: empty archive gives an empty output");
+    TEST_ASSERT(cipher_file_decrypt("/nonexistent/archive", NULL, KEY,
+                                    CIPHER_RECORDS_NEWLINE, NULL)
+                    == CIPHER_ERROR_IO,
+                "files: missing archive returns CIPHER_ERROR_IO");
+
+    unlink(in_path);
+    unlink(out_path);
+}
+
+/* -------------------------------------------------------------------------
+ * Main
+ * ---------------------------------------------------------------------- */
+
+int main(void)
+{
+    printf("\n=== Embedded Cipher Library — File Unit Tests ===\n\n");
+
+    test_records();
+    test_files();
+
+    printf("\n--- Results: %d/%d passed ---\n\n",
+           tests_run - tests_failed, tests_run);
+
+    return (tests_failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file test_cipher_mt.c
+ * @brief Unit tests for the multithreaded batch API (host only).
+ *
+ * Build and run (from repo root):
+ *   make test
+ *
+ * Exit code 0 = all tests passed.
+ * Exit code 1 = one or more tests failed.
+ *
+ * @author Rushikesh Kaduskar
+ */
+
+#include "cipher.h"
+#include "cipher_mt.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+/* -------------------------------------------------------------------------
+ * Minimal test framework (no external dependencies)
+ * ---------------------------------------------------------------------- */
+
+static int tests_run    = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(condition, message)          \
+    do {                                         \
+        tests_run++;                             \
+        if (!(condition)) {                      \
+            tests_failed++;                      \
+            printf("[FAIL] %s\n"                 \
+                   "       %s:%d — %s\n",        \
+                   message, __FILE__, __LINE__,  \
+                   #condition);                  \
+        } else {                                 \
+            printf("[PASS] %s\n", message);      \
+        }                                        \
+    } while (0)
+
+/* -------------------------------------------------------------------------
+ * Fixtures
+ * ---------------------------------------------------------------------- */
+
+#define FRAMES 997U
+#define ARENA  (FRAMES * 600U)
+
+static char            arena[ARENA];
+static char            expect[ARENA];
+static cipher_span_t   frames[FRAMES];
+static cipher_span_t   expect_frames[FRAMES];
+static cipher_status_t status[FRAMES];
+static cipher_status_t expect_status[FRAMES];
+
+/** Frames of very uneven length, so stealing has work to move around. */
+static void build_frames(void)
+{
+    size_t i, off = 0, len;
+
+    for (i = 0; i < ARENA; i++) {
+        arena[i] = "0123456789ABCDEF:,=;"[(i * 13U) % 20U];
+    }
+    memcpy(expect, arena, ARENA);
+    for (i = 0; i < FRAMES; i++) {
+        len = (i % 50U == 0U) ? 590U : (i * 7U) % 40U;
+        frames[i].data        = arena + off;
+        frames[i].len         = len;
+        expect_frames[i].data = expect + off;
+        expect_frames[i].len  = len;
+        off += len;
+    }
+}
+
+/* -------------------------------------------------------------------------
+ * Test cases
+ * ---------------------------------------------------------------------- */
+
+/** Pool results must match the single-threaded batch API. */
+static void test_mt_matches_batch(void)
+{
+    static const unsigned threads[3] = { 1, 3, 8 };
+    cipher_mt_pool_t *pool;
+    size_t t;
+    int ok = 1;
+
+    for (t = 0; t < 3; t++) {
+        build_frames();
+        pool = cipher_mt_pool_create(threads[t]);
+        if (pool == NULL) {
+            ok = 0;
+            continue;
+        }
+        cipher_encrypt_batch(expect_frames, FRAMES, 4321, expect_status);
+        if (cipher_mt_encrypt_batch(pool, frames, FRAMES, 4321, status)
+                != CIPHER_SUCCESS
+            || memcmp(arena, expect, ARENA) != 0) {
+            ok = 0;
+        }
+        cipher_decrypt_batch(expect_frames, FRAMES, 4321, expect_status);
+        if (cipher_mt_decrypt_batch(pool, frames, FRAMES, 4321, NULL)
+                != CIPHER_SUCCESS
+            || memcmp(arena, expect, ARENA) != 0) {
+            ok = 0;
+        }
+        cipher_mt_pool_destroy(pool);
+    }
+    TEST_ASSERT(ok, "mt_matches_batch: 1/3/8 workers match cipher_*_batch");
+}
+
+/** The lowest failing frame decides the return value. */
+static void test_mt_status(void)
+{
+    cipher_mt_pool_t *pool = cipher_mt_pool_create(4);
+    cipher_status_t result;
+
+    build_frames();
+    frames[900].data = NULL;
+    frames[301].len  = CIPHER_MAX_INPUT_LEN + 1U;
+
+    result = cipher_mt_decrypt_batch(pool, frames, FRAMES, 5, status);
+    TEST_ASSERT(result == CIPHER_ERROR_INVALID_LENGTH,
+                "mt_status: returns the error of the lowest failing frame");
+    TEST_ASSERT(status[301] == CIPHER_ERROR_INVALID_LENGTH
+                    && status[900] == CIPHER_ERROR_NULL_POINTER
+                    && status[0] == CIPHER_SUCCESS,
+                "mt_status: per-frame status is recorded");
+    TEST_ASSERT(cipher_mt_decrypt_batch(pool, NULL, 1, 5, NULL)
+                    == CIPHER_ERROR_NULL_POINTER,
+                "mt_status: NULL frames returns CIPHER_ERROR_NULL_POINTER");
+    TEST_ASSERT(cipher_mt_decrypt_batch(NULL, frames, 1, 5, NULL)
+                    == CIPHER_ERROR_NULL_POINTER,
+                "mt_status: NULL pool returns CIPHER_ERROR_NULL_POINTER");
+    cipher_mt_pool_destroy(pool);
+}
+
+/** Per-worker plan caches: same results, counters summed over workers. */
+static void test_mt_plan_cache(void)
+{
+    cipher_mt_pool_t *pool = cipher_mt_pool_create(4);
+    cipher_plan_cache_stats_t st;
+    int ok;
+
+    build_frames();
+    frames[17].data = NULL;
+    expect_frames[17].data = NULL;
+    ok = pool != NULL && cipher_mt_pool_plan_cache(pool, 4096) == CIPHER_SUCCESS;
+
+    cipher_encrypt_batch(expect_frames, FRAMES, 4321, expect_status);
+    ok = ok && cipher_mt_encrypt_batch(pool, frames, FRAMES, 4321, status)
+                   == CIPHER_ERROR_NULL_POINTER
+            && memcmp(arena, expect, ARENA) == 0
+            && memcmp(status, expect_status, sizeof status) == 0;
+    cipher_decrypt_batch(expect_frames, FRAMES, 4321, expect_status);
+    ok = ok && cipher_mt_decrypt_batch(pool, frames, FRAMES, 4321, status)
+                   == CIPHER_ERROR_NULL_POINTER
+            && memcmp(arena, expect, ARENA) == 0;
+    TEST_ASSERT(ok, "mt_plan_cache: cached workers match cipher_*_batch");
+
+    cipher_mt_pool_plan_stats(pool, &st);
+    TEST_ASSERT(st.hits + st.misses == 2U * (FRAMES - 1U) && st.hits > st.misses,
+                "mt_plan_cache: every frame is one lookup, mostly hits");
+
+    TEST_ASSERT(cipher_mt_pool_plan_cache(pool, 0) == CIPHER_SUCCESS,
+                "mt_plan_cache: 0 turns caching off");
+    cipher_mt_pool_destroy(pool);
+}
+
+/* Helper thread for test_mt_stats(): five calls, own snapshot */
+static void *stats_thread(void *arg)
+{
+    char buf[] = "0123456789ABCDEF";
+    int i;
+
+    cipher_stats_reset();
+    for (i = 0; i < 5; i++) {
+        cipher_encrypt_buf(buf, 16, 3);
+    }
+    cipher_stats_snapshot((cipher_stats_t *)arg);
+    return NULL;
+}
+
+static void test_mt_stats(void)
+{
+    cipher_stats_t mine, theirs;
+    char buf[] = "0123456789ABCDEF";
+    pthread_t t;
+    int ok;
+
+    cipher_stats_reset();
+    cipher_encrypt_buf(buf, 16, 3);
+    ok = pthread_create(&t, NULL, stats_thread, &theirs) == 0;
+    ok = ok && pthread_join(t, NULL) == 0;
+    cipher_stats_snapshot(&mine);
+
+#if CIPHER_ENABLE_STATS && CIPHER_STATS_PER_THREAD
+    TEST_ASSERT(ok && mine.calls == 1U && theirs.calls == 5U &&
+                theirs.bytes == 80U,
+                "mt_stats: every thread counts into its own stats");
+#else
+    TEST_ASSERT(ok, "mt_stats: calls from another thread succeed");
+#endif
+}
+
+/* -------------------------------------------------------------------------
+ * Main
+ * ---------------------------------------------------------------------- */
+
+int main(void)
+{
+    printf("\n=== Embedded Cipher Library — MT Unit Tests ===\n\n");
+
+    test_mt_matches_batch();
+    test_mt_status();
+    test_mt_plan_cache();
+    test_mt_stats();
+
+    printf("\n--- Results: %d/%d passed ---\n\n",
+           tests_run - tests_failed, tests_run);
+
+    return (tests_failed > 0) ? 1 : 0;
+}